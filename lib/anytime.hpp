@@ -0,0 +1,77 @@
+#ifndef GENETIC_TSP_ANYTIME_HPP
+#define GENETIC_TSP_ANYTIME_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace genetic {
+
+// Latest value published by a single writer thread, readable from any
+// thread without locks. The writer fills the slot that readers are not
+// pointed at and then flips them to it. A sequence number per slot makes a
+// reader retry in the rare case the writer came back to its slot, two
+// publications later, while the reader was still copying it.
+template <typename T> class Snapshot {
+  static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+  void publish(const T &value) {
+    const auto next = 1 - m_current.load(std::memory_order_relaxed);
+    auto &slot = m_slots[next];
+    const auto sequence = slot.sequence.load(std::memory_order_relaxed);
+    // Odd while the slot is being written
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&slot.value, &value, sizeof(T));
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    m_current.store(next, std::memory_order_release);
+  }
+
+  // Copies the latest value, returning false if none was published yet
+  bool read(T &value) const {
+    while (true) {
+      const auto &slot = m_slots[m_current.load(std::memory_order_acquire)];
+      const auto sequence = slot.sequence.load(std::memory_order_acquire);
+      if (sequence == 0)
+        return false;
+      if (sequence % 2 == 1)
+        continue;
+      std::memcpy(&value, &slot.value, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) == sequence)
+        return true;
+    }
+  }
+
+private:
+  struct Slot {
+    std::atomic<uint64_t> sequence{0};
+    T value{};
+  };
+  std::array<Slot, 2> m_slots{};
+  std::atomic<size_t> m_current{0};
+};
+
+// Flag asking a run to stop at the end of its current generation. Copies
+// share the flag, so one can be kept by the caller and one given to the
+// run.
+class CancellationToken {
+public:
+  CancellationToken() : m_cancelled(std::make_shared<std::atomic<bool>>()) {}
+
+  // Lock-free, so it can be called from a signal handler
+  void cancel() const { m_cancelled->store(true, std::memory_order_relaxed); }
+  [[nodiscard]] bool cancelled() const {
+    return m_cancelled->load(std::memory_order_relaxed);
+  }
+
+private:
+  std::shared_ptr<std::atomic<bool>> m_cancelled;
+};
+} // namespace genetic
+
+#endif // GENETIC_TSP_ANYTIME_HPP
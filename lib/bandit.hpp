@@ -0,0 +1,63 @@
+#ifndef GENETIC_TSP_BANDIT_HPP
+#define GENETIC_TSP_BANDIT_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <random>
+#include <vector>
+
+namespace genetic {
+
+// Adaptive pursuit over a few arms, used to pick operators by the reward
+// they currently earn. Each arm keeps a recency-weighted average of its
+// rewards, and the probabilities are pulled towards the best arm while
+// never falling below min_probability, so that every arm keeps being
+// sampled as rewards drift during a run.
+class Bandit {
+public:
+  explicit Bandit(size_t n_arms, double learning_rate = 0.1,
+                  double min_probability = 0.05)
+      : m_quality(n_arms, 0.), m_probability(n_arms, 1. / double(n_arms)),
+        m_learning_rate(learning_rate),
+        m_min_probability(std::min(min_probability, 1. / double(n_arms))) {}
+
+  [[nodiscard]] size_t size() const { return m_quality.size(); }
+
+  [[nodiscard]] const std::vector<double> &probabilities() const {
+    return m_probability;
+  }
+
+  template <class RNG> size_t choose(RNG &rng) {
+    std::uniform_real_distribution<double> uniform(0, 1);
+    auto u = uniform(rng);
+    for (size_t arm = 0; arm + 1 < size(); arm++) {
+      if (u < m_probability[arm])
+        return arm;
+      u -= m_probability[arm];
+    }
+    return size() - 1;
+  }
+
+  void reward(size_t arm, double reward) {
+    m_quality[arm] += m_learning_rate * (reward - m_quality[arm]);
+    const auto best = size_t(std::distance(
+        m_quality.cbegin(),
+        std::max_element(m_quality.cbegin(), m_quality.cend())));
+    const auto max_probability =
+        1. - double(size() - 1) * m_min_probability;
+    for (size_t a = 0; a < size(); a++) {
+      const auto target = a == best ? max_probability : m_min_probability;
+      m_probability[a] += m_learning_rate * (target - m_probability[a]);
+    }
+  }
+
+private:
+  std::vector<double> m_quality;
+  std::vector<double> m_probability;
+  double m_learning_rate;
+  double m_min_probability;
+};
+} // namespace genetic
+
+#endif // GENETIC_TSP_BANDIT_HPP
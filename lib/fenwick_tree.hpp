@@ -0,0 +1,75 @@
+#ifndef GENETIC_TSP_FENWICK_TREE_HPP
+#define GENETIC_TSP_FENWICK_TREE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "utils.hpp"
+
+namespace genetic {
+
+// Binary indexed tree over non-negative weights: O(log N) updates and
+// inverse prefix sum queries, which make roulette sampling O(log N).
+template <typename T> class FenwickTree {
+public:
+  FenwickTree() = default;
+
+  template <typename InputIt> void assign(InputIt first, size_t N) {
+    m_values.assign(first, snext(first, N));
+    m_tree.assign(N + 1, T(0));
+    for (size_t i = 1; i <= N; i++) {
+      m_tree[i] += m_values[i - 1];
+      const auto parent = i + lowest_bit(i);
+      if (parent <= N)
+        m_tree[parent] += m_tree[i];
+    }
+  }
+
+  void set(size_t i, const T value) {
+    const auto delta = value - m_values[i];
+    m_values[i] = value;
+    for (auto j = i + 1; j < m_tree.size(); j += lowest_bit(j)) {
+      m_tree[j] += delta;
+    }
+  }
+
+  [[nodiscard]] T operator[](size_t i) const { return m_values[i]; }
+  [[nodiscard]] size_t size() const { return m_values.size(); }
+
+  // Sum of the first n weights
+  [[nodiscard]] T prefix(size_t n) const {
+    T sum(0);
+    for (; n > 0; n -= lowest_bit(n)) {
+      sum += m_tree[n];
+    }
+    return sum;
+  }
+
+  [[nodiscard]] T total() const { return prefix(size()); }
+
+  // Index i such that prefix(i) <= target < prefix(i + 1)
+  [[nodiscard]] size_t find(T target) const {
+    size_t position = 0;
+    size_t step = 1;
+    while (step * 2 <= size())
+      step *= 2;
+    for (; step > 0; step /= 2) {
+      if (position + step <= size() && m_tree[position + step] <= target) {
+        position += step;
+        target -= m_tree[position];
+      }
+    }
+    return std::min(position, size() - 1);
+  }
+
+private:
+  std::vector<T> m_values{};
+  // 1-based: m_tree[i] holds the sum of the lowest_bit(i) weights up to i
+  std::vector<T> m_tree{};
+
+  static constexpr size_t lowest_bit(size_t i) { return i & (~i + 1); }
+};
+} // namespace genetic
+
+#endif // GENETIC_TSP_FENWICK_TREE_HPP
@@ -0,0 +1,38 @@
+#ifndef GENETIC_TSP_FITNESS_CACHE_HPP
+#define GENETIC_TSP_FITNESS_CACHE_HPP
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace genetic {
+
+// Direct-mapped cache of fitness values keyed by individual hashes. A newer
+// entry evicts the one occupying its slot; hash 0 is never stored.
+template <typename Hash, typename FitnessMeasure> class FitnessCache {
+public:
+  explicit FitnessCache(size_t log2_size = 12)
+      : m_mask((size_t(1) << log2_size) - 1), m_hashes(m_mask + 1),
+        m_fitnesses(m_mask + 1) {}
+
+  [[nodiscard]] std::optional<FitnessMeasure> find(const Hash hash) const {
+    const auto slot = size_t(hash) & m_mask;
+    if (hash != Hash{} && m_hashes[slot] == hash)
+      return m_fitnesses[slot];
+    return std::nullopt;
+  }
+
+  void insert(const Hash hash, const FitnessMeasure fitness) {
+    const auto slot = size_t(hash) & m_mask;
+    m_hashes[slot] = hash;
+    m_fitnesses[slot] = fitness;
+  }
+
+private:
+  size_t m_mask;
+  std::vector<Hash> m_hashes;
+  std::vector<FitnessMeasure> m_fitnesses;
+};
+} // namespace genetic
+
+#endif // GENETIC_TSP_FITNESS_CACHE_HPP
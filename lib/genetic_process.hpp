@@ -9,9 +9,17 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
 #include <random>
+#include <type_traits>
+#include <unordered_set>
 #include <vector>
 
 #ifdef USE_MPI
@@ -21,59 +29,345 @@
 #include <indicators/dynamic_progress.hpp>
 #include <indicators/progress_bar.hpp>
 
+#include "anytime.hpp"
+#include "bandit.hpp"
+#include "fenwick_tree.hpp"
+#include "fitness_cache.hpp"
+#include "numa.hpp"
+#include "scheduler.hpp"
+#include "selection.hpp"
+#include "thread_pool.hpp"
 #include "utils.hpp"
 
 namespace genetic {
 
-template <class GA> class Process {
+namespace detail {
+// Whether GA::replicate makes a copy owning its read-only data
+template <class GA, typename = void> struct has_replicate : std::false_type {};
+template <class GA>
+struct has_replicate<
+    GA, std::void_t<decltype(std::declval<const GA &>().replicate())>>
+    : std::true_type {};
+} // namespace detail
+
+template <class GA, class Selection = selection::Roulette> class Process {
   using Individual = typename GA::Individual;
+  using FitnessMeasure = typename GA::FitnessMeasure;
+  using Hash = typename GA::Hash;
+  using EdgeTable = typename GA::EdgeTable;
+  static constexpr bool is_roulette =
+      std::is_same_v<Selection, selection::Roulette>;
 
 public:
-  explicit Process(GA &&ga) : m_ga(std::forward<GA>(ga)) {}
+  explicit Process(GA &&ga, Selection selection = Selection())
+      : m_ga(std::forward<GA>(ga)), m_selection(std::move(selection)) {}
 
+  // With set_threads, the workers generate the chunks of the population,
+  // each from its own engine as when breeding, and hash them
   template <typename PopulationIt, class RNG>
   inline constexpr void generate(PopulationIt first_individual, size_t N,
                                  RNG &rng) {
-    return m_ga.generate(first_individual, N, rng);
+    resize_state(N);
+    if (m_pool) {
+      draw_chunk_seed(rng);
+      for_each_chunk(N, [&](Worker &worker, auto &chunk_rng, size_t begin,
+                            size_t end) {
+        worker.ga.generate(snext(first_individual, begin), end - begin,
+                           chunk_rng, begin);
+        for (auto i = begin; i < end; i++) {
+          m_hashes[i] = worker.ga.hash(*snext(first_individual, i));
+        }
+      });
+    } else {
+      m_ga.generate(first_individual, N, rng);
+      hash(first_individual, N, m_hashes.begin());
+    }
+    m_parents_selected = false;
+    m_generation = 0;
+    m_has_best = false;
   }
 
   template <typename PopulationIt, typename EvaluationsIt>
   inline constexpr void evaluate(PopulationIt first_individual, size_t N,
                                  EvaluationsIt first_evaluation) {
+    if (m_pool) {
+      for_each_chunk(N, [&](Worker &worker, auto &, size_t begin, size_t end) {
+        std::transform(snext(first_individual, begin),
+                       snext(first_individual, end),
+                       snext(first_evaluation, begin),
+                       [&](const auto &i) { return worker.ga.evaluate(i); });
+      });
+      return;
+    }
     std::transform(first_individual, snext(first_individual, N),
                    first_evaluation,
                    [&](const auto &i) { return m_ga.evaluate(i); });
   }
 
+  // Copies the selected parents in order, for crossover to breed from them.
+  // Runs do not copy them, but breed from the population in place.
   template <typename PopulationIt, typename ParentIt, typename EvaluationsIt,
             class RNG>
-  inline constexpr void
-  select_parents(PopulationIt first_individual, size_t N, ParentIt first_parent,
-                 EvaluationsIt first_evaluation, RNG &rng) {
-    m_ga.select_parents(first_individual, N, first_parent, first_evaluation,
-                        rng);
-    std::shuffle(first_parent, snext(first_parent, N), rng);
+  inline void select_parents(PopulationIt first_individual, size_t N,
+                             ParentIt first_parent,
+                             EvaluationsIt first_evaluation, RNG &rng) {
+    select(first_evaluation, N, rng);
+    for (size_t i = 0; i < N; i++) {
+      *snext(first_parent, i) = *snext(first_individual, m_selected[i]);
+    }
+    std::iota(m_selected.begin(), m_selected.end(), 0);
   }
 
+  // Writes the children of the parents selected from the population of
+  // first_parent, as by select_parents, to first_child
   template <typename PopulationInIt, typename PopulationOutIt, class RNG>
   inline constexpr void crossover(PopulationInIt first_parent, size_t N,
                                   PopulationOutIt first_child, RNG &rng) {
-    for (size_t i = 0; i < N; i += 2) {
-      const auto [eldest, youngest] = m_ga.crossover(
-          *snext(first_parent, i), *snext(first_parent, i + 1), rng);
-      *snext(first_child, i) = std::move(eldest);
-      *snext(first_child, i + 1) = std::move(youngest);
-    }
+    crossover(m_ga, first_parent, first_child, 0, N, rng);
   }
 
   template <typename PopulationIt, class RNG>
   inline constexpr void mutate(PopulationIt first_individual, size_t N,
                                double mutation_probability, RNG &rng) {
-    std::for_each(first_individual, snext(first_individual, N),
-                  [&](auto &individual) {
-                    if (m_mutprob(rng) < mutation_probability)
-                      m_ga.mutate(individual, rng);
-                  });
+    mutate(m_ga, first_individual, 0, N, mutation_probability, rng);
+  }
+
+  // Mutates the later copies of any individual already in the population,
+  // giving up on an individual after a few attempts
+  template <typename PopulationIt, class RNG>
+  void replace_duplicates(PopulationIt first_individual, size_t N, RNG &rng) {
+    m_seen.clear();
+    for (size_t i = 0; i < N; i++) {
+      for (auto attempt = 0U;
+           !m_seen.insert(m_hashes[i]).second && attempt < 8U; attempt++) {
+        m_ga.mutate(*snext(first_individual, i), m_hashes[i], rng);
+        m_changed[i] = true;
+        m_n_replaced_duplicates++;
+      }
+    }
+  }
+
+  // Whether duplicate individuals are replaced before every evaluation. In
+  // steady-state mode, children identical to a parent are discarded instead.
+  void set_replace_duplicates(bool replace) { m_replace_duplicates = replace; }
+
+  // Mutates the children more similar than the maximum to their parents,
+  // selected from the population of first_parent, giving up on a child after
+  // a few attempts
+  template <typename PopulationIt, typename ParentIt, class RNG>
+  void reject_similar(PopulationIt first_individual, size_t N,
+                      ParentIt first_parent, RNG &rng) {
+    m_edges.clear();
+    for (size_t i = 0; i < N; i++) {
+      m_edges.add(*snext(first_parent, m_selected[i]));
+    }
+    for (size_t i = 0; i < N; i++) {
+      auto &individual = *snext(first_individual, i);
+      for (auto attempt = 0U;
+           m_edges.similarity(individual) > m_max_similarity && attempt < 8U;
+           attempt++) {
+        m_ga.mutate(individual, m_hashes[i], rng);
+        m_changed[i] = true;
+        m_n_rejected_similar++;
+      }
+    }
+  }
+  // Whether children are rejected before every evaluation when their mean
+  // similarity to the population, measured by GA::EdgeTable, exceeds
+  // max_similarity. In steady-state mode they are discarded instead. 1
+  // disables it.
+  void set_max_similarity(double max_similarity) {
+    m_max_similarity = max_similarity;
+  }
+  [[nodiscard]] size_t n_rejected_similar() const {
+    return m_n_rejected_similar;
+  }
+
+  // In steady-state mode each step breeds a single pair of children, which
+  // replace individuals of the current population. An iteration is made of
+  // population_size / 2 steps, so that it breeds as many children as a
+  // generation.
+  void set_steady_state(bool steady_state) { m_steady_state = steady_state; }
+
+  // Breeds and evaluates the generations on n_threads worker threads,
+  // pinned to CPUs spread over the NUMA nodes, 1 to stay on the calling
+  // thread. The population is cut into chunks of pairs, scheduled by work
+  // stealing: each worker starts from the chunks of its own slice, and
+  // takes over those of others once done. Workers breed with their own copy
+  // of the GA, and each chunk with a random engine seeded from the one of
+  // the run and its position, so that runs are reproducible whatever the
+  // scheduling, unless the GA adapts its operators. The copies are made on
+  // the workers, those of the first worker of each node by GA::replicate if
+  // it exists, so that the read-only data of the GA is local to each node.
+  // Steady-state runs and the other steps stay on the calling thread.
+  void set_threads(size_t n_threads) {
+    m_scheduler.reset();
+    m_workers.clear();
+    m_pool.reset();
+    if (n_threads <= 1)
+      return;
+    m_pool = std::make_unique<ThreadPool>(n_threads);
+    m_workers.resize(n_threads);
+    m_pool->run([&](const size_t w) {
+      if (m_pool->leader(w) != w)
+        return;
+      if constexpr (detail::has_replicate<GA>::value)
+        m_workers[w] =
+            std::make_unique<Worker>(Worker{m_ga.replicate(), m_selection});
+      else
+        m_workers[w] = std::make_unique<Worker>(Worker{GA(m_ga), m_selection});
+    });
+    m_pool->run([&](const size_t w) {
+      if (m_pool->leader(w) != w)
+        m_workers[w] = std::make_unique<Worker>(
+            Worker{GA(m_workers[m_pool->leader(w)]->ga), m_selection});
+    });
+    m_scheduler = std::make_unique<Scheduler>(*m_pool);
+  }
+  [[nodiscard]] size_t n_threads() const {
+    return m_pool ? m_pool->size() : 1;
+  }
+  // Individuals per chunk of set_threads, rounded up to pairs. Smaller
+  // chunks balance better the workers when costs vary, such as under local
+  // search, at the price of more scheduling.
+  void set_chunk_size(size_t chunk_size) {
+    m_chunk_size = std::max(chunk_size + chunk_size % 2, size_t(2));
+  }
+  // Whether the generations of set_threads are pipelined rather than bred
+  // one after the other. Each chunk then selects the parents of its next
+  // generation among the individuals of the chunks within radius of it,
+  // around the population taken as a ring, instead of the whole population,
+  // and breeds them as soon as those chunks are evaluated: workers breed
+  // and evaluate later generations of some chunks while others are still
+  // at earlier ones. The children go to a second population buffer, so
+  // that the parents are kept until all their neighbours are bred. A
+  // smaller radius waits on fewer chunks, but spreads good individuals more
+  // slowly. The mutation probability is fixed and children are not
+  // screened, so runs throw if set_adaptive_mutation, set_max_similarity or
+  // set_replace_duplicates is also set. Runs are reproducible whatever the
+  // scheduling, as with set_threads. In mpi_run each block starts from the
+  // evaluated population.
+  void set_pipelined(bool pipelined, size_t radius = 1) {
+    m_pipelined = pipelined;
+    m_radius = std::max(radius, size_t(1));
+  }
+
+  // Time spent and chunks run by each worker of set_threads, over all runs
+  [[nodiscard]] std::vector<Scheduler::WorkerStats> worker_stats() const {
+    return m_scheduler ? m_scheduler->stats()
+                       : std::vector<Scheduler::WorkerStats>();
+  }
+  // Fraction of the time spent in parallel steps that each worker was busy
+  [[nodiscard]] std::vector<double> worker_utilisation() const {
+    std::vector<double> utilisation(m_scheduler ? m_scheduler->size() : 0);
+    for (size_t w = 0; w < utilisation.size(); w++) {
+      utilisation[w] = m_scheduler->utilisation(w);
+    }
+    return utilisation;
+  }
+
+  // N values for a run, such as the population and its evaluations, of
+  // which each worker of set_threads writes its own slice first, so that it
+  // is allocated on the node of the worker. Value-initialised.
+  template <typename T> numa::FirstTouchVector<T> allocate(size_t N) {
+    if (m_pool)
+      return m_pool->allocate<T>(N, 2);
+    return numa::FirstTouchVector<T>(N, T{});
+  }
+
+  [[nodiscard]] const GA &ga() const { return m_ga; }
+  // GA with which the given worker of set_threads breeds and evaluates its
+  // chunks, and whose adaptive operators learn from them alone
+  [[nodiscard]] const GA &ga(size_t worker) const {
+    return m_workers.empty() ? m_ga : m_workers[worker]->ga;
+  }
+
+  // Number of individuals evaluated and of evaluations skipped because the
+  // individual was an unchanged copy of its parent
+  [[nodiscard]] size_t n_evaluations() const { return m_tally.n_evaluations; }
+  [[nodiscard]] size_t n_skipped_evaluations() const {
+    return m_tally.n_skipped_evaluations;
+  }
+  // Evaluations served by the fitness cache, also counted as skipped
+  [[nodiscard]] size_t n_cache_hits() const { return m_tally.n_cache_hits; }
+  [[nodiscard]] size_t n_replaced_duplicates() const {
+    return m_n_replaced_duplicates;
+  }
+
+  // Makes mpi_run stop after the first block whose best individual is within
+  // the relative gap of fitness_bound, an upper bound on the fitness. The
+  // gap of a fitness f is fitness_bound / f - 1, which for a fitness
+  // inversely proportional to a cost is the relative excess over the lowest
+  // possible cost.
+  void set_stop_gap(FitnessMeasure fitness_bound, double gap) {
+    m_fitness_bound = fitness_bound;
+    m_stop_gap = gap;
+  }
+
+  // Gap of the best individual after the last block of mpi_run, if a fitness
+  // bound was set
+  [[nodiscard]] double gap() const { return m_gap; }
+
+  // Convergence of mpi_run, recorded after each block over all processes
+  struct BlockStats {
+    // Best fitness so far and mean fitness of the block
+    FitnessMeasure best;
+    double mean;
+    // Fraction of distinct individuals in the population
+    double diversity;
+    // Diversity of the edges used by the population, see GA::EdgeTable
+    double edge_diversity;
+  };
+  [[nodiscard]] const std::vector<BlockStats> &history() const {
+    return m_history;
+  }
+
+  // What mpi_run does once the best fitness has not improved for a window
+  // of blocks: stop, or restart by replacing all but the elite_fraction best
+  // individuals of the population bred from with newly generated ones.
+  enum class Stagnation { ignore, stop, restart };
+  void set_stagnation(size_t window, Stagnation action,
+                      double elite_fraction = 0.1) {
+    m_stagnation_window = window;
+    m_on_stagnation = action;
+    m_elite_fraction = elite_fraction;
+  }
+  [[nodiscard]] size_t n_restarts() const { return m_n_restarts; }
+
+  // Whether each generation mutates with a multiple of the given mutation
+  // probability, picked by the fitness it recently gained per second
+  void set_adaptive_mutation(bool adaptive) { m_adaptive_mutation = adaptive; }
+  // Expected multiple of the mutation probability under the current control
+  [[nodiscard]] double mutation_probability_factor() const {
+    if (!m_adaptive_mutation)
+      return 1;
+    const auto &probabilities = m_rates.probabilities();
+    return std::inner_product(probabilities.cbegin(), probabilities.cend(),
+                              rate_factors.cbegin(), 0.);
+  }
+
+  // Best individual found so far by a run, as of the end of its last
+  // generation. Under MPI, each process reports its own.
+  struct Best {
+    Individual individual;
+    FitnessMeasure fitness;
+    // Generations bred so far, 0 for the initial population
+    size_t generation;
+  };
+  // Safe to call from any thread while a run goes on. Empty until the first
+  // run has evaluated its initial population.
+  [[nodiscard]] std::optional<Best> best() const {
+    Best best{};
+    if (!m_best.read(best))
+      return std::nullopt;
+    return best;
+  }
+
+  // Runs stop at the end of the generation during which the token is
+  // cancelled, leaving the population of the last generation bred. mpi_run
+  // stops all processes at the end of the block.
+  void set_cancellation(CancellationToken token) {
+    m_cancellation = std::move(token);
   }
 
   template <typename PopulationIt, typename EvaluationsIt, class RNG>
@@ -81,15 +375,29 @@ public:
                             size_t population_size,
                             EvaluationsIt first_evaluation, size_t n_iterations,
                             double mutation_probability, RNG &rng) {
+    check_pipelined();
     generate(first_individual, population_size, rng);
     evaluate(first_individual, population_size, first_evaluation);
+    publish_best(first_individual, first_evaluation, population_size);
 
     if (n_iterations == 0)
       return;
 
-    std::vector<Individual> parents_buffer(population_size);
-    loop_from_start(first_individual, population_size, parents_buffer.begin(),
-                    first_evaluation, n_iterations, mutation_probability, rng);
+    if (m_steady_state) {
+      steady_state_loop(first_individual, population_size, first_evaluation,
+                        n_iterations * population_size / 2,
+                        mutation_probability, rng);
+      return;
+    }
+    if (pipelined()) {
+      pipelined_loop(first_individual, population_size, first_evaluation,
+                     n_iterations, mutation_probability, rng);
+      return;
+    }
+    auto buffer = allocate<Individual>(population_size);
+    generational_loop(first_individual, population_size, buffer.begin(),
+                      first_evaluation, n_iterations, mutation_probability,
+                      rng);
   }
 
   template <size_t POPULATION_SIZE, typename PopulationIt,
@@ -98,15 +406,29 @@ public:
                             EvaluationsIt first_evaluation, size_t n_iterations,
                             double mutation_probability, RNG &rng) {
     static_assert(POPULATION_SIZE <= 1000);
+    check_pipelined();
     generate(first_individual, POPULATION_SIZE, rng);
     evaluate(first_individual, POPULATION_SIZE, first_evaluation);
+    publish_best(first_individual, first_evaluation, POPULATION_SIZE);
 
     if (n_iterations == 0)
       return;
 
-    std::array<Individual, POPULATION_SIZE> parents_buffer{};
-    loop_from_start(first_individual, POPULATION_SIZE, parents_buffer.begin(),
-                    first_evaluation, n_iterations, mutation_probability, rng);
+    if (m_steady_state) {
+      steady_state_loop(first_individual, POPULATION_SIZE, first_evaluation,
+                        n_iterations * POPULATION_SIZE / 2,
+                        mutation_probability, rng);
+      return;
+    }
+    if (pipelined()) {
+      pipelined_loop(first_individual, POPULATION_SIZE, first_evaluation,
+                     n_iterations, mutation_probability, rng);
+      return;
+    }
+    std::array<Individual, POPULATION_SIZE> buffer{};
+    generational_loop(first_individual, POPULATION_SIZE, buffer.begin(),
+                      first_evaluation, n_iterations, mutation_probability,
+                      rng);
   }
 
   template <typename PopulationIt, typename EvaluationsIt, class RNG>
@@ -115,8 +437,10 @@ public:
                size_t n_blocks, double mutation_probability, RNG &rng) {
     using namespace indicators;
 
+    check_pipelined();
     generate(first_individual, population_size, rng);
     evaluate(first_individual, population_size, first_evaluation);
+    publish_best(first_individual, first_evaluation, population_size);
 
     if (n_blocks == 0)
       return;
@@ -137,114 +461,806 @@ public:
     }
 #ifdef USE_MPI
     const auto individual_per_process = signed(population_size) / n_procs;
-    std::vector<size_t> ranks(population_size);
+    std::vector<size_t> elite_indices(population_size);
 #endif
-    std::vector<Individual> population_buffer(population_size);
+    // Second buffer of the generations, and elite gathered from all processes
+    auto population_buffer = allocate<Individual>(population_size);
 
-    select_parents(first_individual, population_size, population_buffer.begin(),
-                   first_evaluation, rng);
+    // Steady-state and pipelined blocks breed from the population itself
+    const auto in_place = m_steady_state || pipelined();
 
     ProgressBar pbar{option::MaxProgress{n_blocks},
                      option::ShowElapsedTime{true},
                      option::ShowRemainingTime{true}, option::BarWidth{80}};
 
     for (auto i = 0U; i < n_blocks; i++) {
-      loop_from_parents(first_individual, population_size,
-                        population_buffer.begin(), first_evaluation,
-                        iterations_per_block, mutation_probability, rng);
+      if (m_steady_state)
+        steady_state_loop(first_individual, population_size, first_evaluation,
+                          iterations_per_block * population_size / 2,
+                          mutation_probability, rng);
+      else if (pipelined())
+        pipelined_loop(first_individual, population_size, first_evaluation,
+                       iterations_per_block, mutation_probability, rng);
+      else
+        generational_loop(first_individual, population_size,
+                          population_buffer.begin(), first_evaluation,
+                          iterations_per_block, mutation_probability, rng);
+      auto best_fitness = *std::max_element(
+          first_evaluation, snext(first_evaluation, population_size));
+      int cancelled = m_cancellation.cancelled() ? 1 : 0;
+#ifdef USE_MPI
+      // Every process must agree on whether this is the last block
+      MPI_Allreduce(MPI_IN_PLACE, &best_fitness, 1, GA::fitness_mpi(), MPI_MAX,
+                    MPI_COMM_WORLD);
+      MPI_Allreduce(MPI_IN_PLACE, &cancelled, 1, MPI_INT, MPI_MAX,
+                    MPI_COMM_WORLD);
+#endif
+      const auto stagnant =
+          monitor(first_individual, first_evaluation, population_size,
+                  best_fitness);
+      // Checked first, so that the gap is also updated on the last block
+      const auto reached = gap_reached(best_fitness);
+      const auto last = i == n_blocks - 1 || reached || cancelled != 0 ||
+                        (stagnant && m_on_stagnation == Stagnation::stop);
 #ifdef USE_MPI
       combine_best_individuals(first_individual, population_size,
                                population_buffer.data(), first_evaluation,
-                               ranks.begin(), individual_per_process,
-                               (i < n_blocks - 1));
-      if (i < n_blocks - 1) {
+                               elite_indices.begin(), individual_per_process,
+                               !last);
+      if (!last) {
+        // The gathered elite becomes the population bred from
         std::shuffle(population_buffer.begin(), population_buffer.end(), rng);
+        std::copy(population_buffer.cbegin(), population_buffer.cend(),
+                  first_individual);
+        hash(first_individual, population_size, m_hashes.begin());
+        if (in_place) {
+          std::fill(m_changed.begin(), m_changed.end(), true);
+          evaluate_changed(first_individual, population_size,
+                           first_evaluation);
+        } else {
+          pair_up(population_size);
+        }
       }
 #endif
+      if (stagnant && !last && m_on_stagnation == Stagnation::restart) {
+        // The population may come from other processes, with unknown fitness
+        if (!in_place && !m_parents_evaluated) {
+          for (size_t k = 0; k < population_size; k++) {
+            *snext(first_evaluation, k) =
+                evaluate_cached(*snext(first_individual, k), m_hashes[k]);
+          }
+        }
+        restart(first_individual, population_size, first_evaluation,
+                m_hashes.begin(), rng);
+        // Selecting from the restarted population
+        m_parents_selected = false;
+      }
       if (mpi_id == 0) {
         pbar.tick();
-        const auto best_fitness = std::max_element(
-            first_evaluation, snext(first_evaluation, population_size));
-        pbar.set_option(option::PostfixText{"best fitness: " +
-                                            std::to_string(*best_fitness)});
+        auto postfix = "best fitness: " + std::to_string(best_fitness) +
+                       ", diversity: " +
+                       std::to_string(100 * m_history.back().diversity) +
+                       "%, edge diversity: " +
+                       std::to_string(m_history.back().edge_diversity);
+        if (m_fitness_bound > 0)
+          postfix += ", gap: " + std::to_string(100 * m_gap) + "%";
+        pbar.set_option(option::PostfixText{postfix});
       }
+      if (last)
+        break;
     }
 
+#ifdef USE_MPI
     if (mpi_id == 0) {
       std::copy(population_buffer.cbegin(), population_buffer.cend(),
                 first_individual);
     }
+#endif
   }
 
 private:
   GA m_ga;
-  std::uniform_real_distribution<double> m_mutprob{};
+  Selection m_selection;
+  // Indices in the population of the parents of each child, and whether they
+  // are selected for the next generation yet
+  std::vector<size_t> m_selected{};
+  bool m_parents_selected{false};
+  // Fitness of the current parents and whether each child differs from its
+  // parent. Parents received from other processes have no known fitness.
+  // Bytes rather than bits, so that workers can write neighbouring entries.
+  std::vector<FitnessMeasure> m_parent_evaluations{};
+  std::vector<uint8_t> m_changed{};
+  bool m_parents_evaluated{false};
+  // Edge hashes of the population and of the parents, kept up to date by the
+  // GA operators
+  std::vector<Hash> m_hashes{};
+  std::vector<Hash> m_parent_hashes{};
+  FitnessCache<Hash, FitnessMeasure> m_cache{};
+  std::unordered_set<Hash> m_seen{};
+  bool m_replace_duplicates{false};
+  bool m_steady_state{false};
+  bool m_pipelined{false};
+  size_t m_radius{1};
+  FenwickTree<FitnessMeasure> m_weights{};
+  // Evaluation counters, also kept by each worker until the end of a
+  // generation
+  struct Tally {
+    size_t n_evaluations{0};
+    size_t n_skipped_evaluations{0};
+    size_t n_cache_hits{0};
+  };
+  Tally m_tally{};
+  size_t m_n_replaced_duplicates{0};
+  // Edge frequencies of the population, or of the parents while rejecting
+  // similar children
+  EdgeTable m_edges{m_ga.edge_table()};
+  double m_max_similarity{1};
+  size_t m_n_rejected_similar{0};
+  FitnessMeasure m_fitness_bound{0};
+  double m_stop_gap{0};
+  double m_gap{0};
+  std::vector<BlockStats> m_history{};
+  size_t m_stagnation_window{0};
+  Stagnation m_on_stagnation{Stagnation::ignore};
+  double m_elite_fraction{0.1};
+  size_t m_stagnant_blocks{0};
+  size_t m_n_restarts{0};
+  static constexpr std::array<double, 5> rate_factors{0.25, 0.5, 1, 2, 4};
+  bool m_adaptive_mutation{false};
+  Bandit m_rates{rate_factors.size()};
+  size_t m_rate{2};
+  std::chrono::steady_clock::time_point m_rate_start{};
+  Snapshot<Best> m_best{};
+  // Writer side copy of the published best
+  Best m_published{};
+  bool m_has_best{false};
+  size_t m_generation{0};
+  CancellationToken m_cancellation{};
+#ifdef USE_MPI
+  std::vector<Individual> m_elite{};
+  std::vector<FitnessMeasure> m_elite_evaluations{};
+#endif
+  // State of a worker of set_threads, allocated on its thread
+  struct Worker {
+    GA ga;
+    Selection selection;
+    FitnessCache<Hash, FitnessMeasure> cache{};
+    Tally tally{};
+    // Indices and evaluations of the neighbourhood of a pipelined chunk, and
+    // the positions in it of the selected parents
+    std::vector<size_t> neighbours{};
+    std::vector<FitnessMeasure> neighbour_evaluations{};
+    std::vector<size_t> selected{};
+  };
+  std::vector<std::unique_ptr<Worker>> m_workers{};
+  size_t m_chunk_size{16};
+  uint64_t m_chunk_seed{0};
+  // Declared after the workers, so that its threads are joined before they
+  // are destroyed
+  std::unique_ptr<ThreadPool> m_pool{};
+  std::unique_ptr<Scheduler> m_scheduler{};
+
+  // Selects the parents of the next generation, by index into the
+  // population, which lets them carry their fitness and hash along
+  template <typename EvaluationsIt, class RNG>
+  void select(EvaluationsIt first_evaluation, size_t N, RNG &rng) {
+    resize_state(N);
+    m_selection.select(m_ga, first_evaluation, N, m_selected.begin(), rng);
+    std::shuffle(m_selected.begin(), m_selected.end(), rng);
+    for (size_t i = 0; i < N; i++) {
+      m_parent_evaluations[i] = *snext(first_evaluation, m_selected[i]);
+      m_parent_hashes[i] = m_hashes[m_selected[i]];
+    }
+    m_parents_evaluated = true;
+    m_parents_selected = true;
+  }
+
+  // Makes the next generation bred from the whole population in consecutive
+  // pairs, without selection nor known fitness, as the elite gathered from
+  // all processes
+  void pair_up(size_t N) {
+    resize_state(N);
+    std::iota(m_selected.begin(), m_selected.end(), 0);
+    std::copy_n(m_hashes.cbegin(), N, m_parent_hashes.begin());
+    m_parents_evaluated = false;
+    m_parents_selected = true;
+  }
+
+  void resize_state(size_t N) {
+    if (m_selected.size() == N)
+      return;
+    m_selected.resize(N);
+    m_parent_evaluations.resize(N);
+    m_changed.resize(N);
+    m_hashes.resize(N);
+    m_parent_hashes.resize(N);
+  }
+
+  // Records the statistics of a block and returns whether the best fitness
+  // has been stagnating for the whole window
+  template <typename PopulationIt, typename EvaluationsIt>
+  bool monitor(PopulationIt first_individual, EvaluationsIt first_evaluation,
+               size_t N, const FitnessMeasure best_fitness) {
+    const auto last_evaluation = snext(first_evaluation, N);
+    m_seen.clear();
+    m_seen.insert(m_hashes.cbegin(), snext(m_hashes.cbegin(), N));
+    m_edges.assign(first_individual, N);
+    std::array<double, 3> averages{
+        std::accumulate(first_evaluation, last_evaluation, 0.,
+                        [](const double total, const auto f) {
+                          return total + double(f);
+                        }) /
+            double(N),
+        double(m_seen.size()) / double(N), m_edges.diversity()};
+#ifdef USE_MPI
+    int n_procs = 1;
+    MPI_Comm_size(MPI_COMM_WORLD, &n_procs);
+    MPI_Allreduce(MPI_IN_PLACE, averages.data(), 3, MPI_DOUBLE, MPI_SUM,
+                  MPI_COMM_WORLD);
+    for (auto &average : averages) {
+      average /= n_procs;
+    }
+#endif
+    if (m_history.empty() || best_fitness > m_history.back().best) {
+      m_stagnant_blocks = 0;
+    } else {
+      m_stagnant_blocks++;
+    }
+    const auto best = m_history.empty()
+                          ? best_fitness
+                          : std::max(best_fitness, m_history.back().best);
+    m_history.push_back(
+        BlockStats{best, averages[0], averages[1], averages[2]});
+    if (m_stagnation_window == 0 || m_stagnant_blocks < m_stagnation_window)
+      return false;
+    m_stagnant_blocks = 0;
+    return true;
+  }
+
+  // Publishes the best individual so far at the end of a generation. The
+  // scan is cheap next to the evaluations.
+  template <typename PopulationIt, typename EvaluationsIt>
+  void publish_best(PopulationIt first_individual,
+                    EvaluationsIt first_evaluation, size_t N) {
+    const auto best = size_t(std::distance(
+        first_evaluation,
+        std::max_element(first_evaluation, snext(first_evaluation, N))));
+    if (!m_has_best || *snext(first_evaluation, best) > m_published.fitness) {
+      m_published.individual = *snext(first_individual, best);
+      m_published.fitness = *snext(first_evaluation, best);
+      m_has_best = true;
+    }
+    m_published.generation = m_generation++;
+    m_best.publish(m_published);
+  }
+
+  // Replaces all but the best individuals with newly generated ones
+  template <typename PopulationIt, typename EvaluationsIt, typename HashIt,
+            class RNG>
+  void restart(PopulationIt first_individual, size_t N,
+               EvaluationsIt first_evaluation, HashIt first_hash, RNG &rng) {
+    const auto n_elite =
+        std::clamp(size_t(m_elite_fraction * double(N)), size_t(1), N);
+    std::vector<size_t> order(N);
+    argpartial_sort_n(first_evaluation, N, n_elite, order.begin(),
+                      std::greater<>());
+    std::vector<Individual> fresh(N - n_elite);
+    m_ga.generate(fresh.begin(), fresh.size(), rng);
+    for (size_t i = n_elite; i < N; i++) {
+      auto &individual = *snext(first_individual, order[i]);
+      individual = std::move(fresh[i - n_elite]);
+      const auto individual_hash = m_ga.hash(individual);
+      *snext(first_hash, order[i]) = individual_hash;
+      *snext(first_evaluation, order[i]) =
+          evaluate_cached(individual, individual_hash);
+    }
+    m_n_restarts++;
+  }
+
+  // Updates the gap of the best fitness and checks it against the target
+  bool gap_reached(const FitnessMeasure best_fitness) {
+    if (m_fitness_bound <= 0)
+      return false;
+    m_gap = double(m_fitness_bound) / double(best_fitness) - 1;
+    return m_gap <= m_stop_gap;
+  }
+
+  template <typename PopulationIt, typename HashIt>
+  inline void hash(PopulationIt first_individual, size_t N,
+                   HashIt first_hash) {
+    std::transform(first_individual, snext(first_individual, N), first_hash,
+                   [&](const auto &i) { return m_ga.hash(i); });
+  }
 
 #ifdef USE_MPI
   template <typename PopulationIt, typename BufferIt, typename EvaluationsIt,
-            typename RanksIt>
+            typename IndicesIt>
   inline void
   combine_best_individuals(PopulationIt first_individual,
                            size_t population_size, BufferIt first_buffer,
-                           EvaluationsIt first_evaluation, RanksIt first_rank,
-                           int individual_per_process, bool all) {
-    rank_n(first_evaluation, population_size, first_rank);
-    order_by_n(first_individual, population_size, first_rank);
-    if (all)
-      MPI_Allgather(&*first_individual, individual_per_process,
+                           EvaluationsIt first_evaluation,
+                           IndicesIt first_index, int individual_per_process,
+                           bool all) {
+    // Only the elite is sent: select it without sorting the population
+    const auto n_elite = size_t(individual_per_process);
+    argpartial_sort_n(first_evaluation, population_size, n_elite, first_index,
+                      std::greater<>());
+    m_elite.resize(n_elite);
+    m_elite_evaluations.resize(n_elite);
+    for (size_t i = 0; i < n_elite; i++) {
+      const auto elite = size_t(*snext(first_index, i));
+      m_elite[i] = std::move(*snext(first_individual, elite));
+      m_elite_evaluations[i] = *snext(first_evaluation, elite);
+    }
+    if (all) {
+      MPI_Allgather(m_elite.data(), individual_per_process,
                     GA::individual_mpi(), first_buffer, individual_per_process,
                     GA::individual_mpi(), MPI_COMM_WORLD);
-    else
-      MPI_Gather(&*first_individual, individual_per_process,
-                 GA::individual_mpi(), first_buffer, individual_per_process,
-                 GA::individual_mpi(), 0, MPI_COMM_WORLD);
+    } else {
+      MPI_Gather(m_elite.data(), individual_per_process, GA::individual_mpi(),
+                 first_buffer, individual_per_process, GA::individual_mpi(), 0,
+                 MPI_COMM_WORLD);
+      // The gathered population replaces the local one in the root process
+      MPI_Gather(m_elite_evaluations.data(), individual_per_process,
+                 GA::fitness_mpi(), &*first_evaluation, individual_per_process,
+                 GA::fitness_mpi(), 0, MPI_COMM_WORLD);
+    }
   }
 #endif
 
+  // Breeds the next generation into first_individual from the selected
+  // parents, read in place in the population of first_parent
   template <typename PopulationIt, typename ParentIt, typename EvaluationsIt,
             class RNG>
   inline void cross_mut_eval(PopulationIt first_individual,
                              size_t population_size, ParentIt first_parent,
                              EvaluationsIt first_evaluation,
                              double mutation_probability, RNG &rng) {
-    crossover(first_parent, population_size, first_individual, rng);
-    mutate(first_individual, population_size, mutation_probability, rng);
-    evaluate(first_individual, population_size, first_evaluation);
+    m_parents_selected = false;
+    const auto probability =
+        next_mutation_probability(mutation_probability, rng);
+    // Screening needs the whole population bred before evaluating
+    const auto screening = m_replace_duplicates || m_max_similarity < 1;
+    if (m_pool) {
+      draw_chunk_seed(rng);
+      for_each_chunk(population_size, [&](Worker &worker, auto &chunk_rng,
+                                          size_t begin, size_t end) {
+        crossover(worker.ga, first_parent, first_individual, begin, end,
+                  chunk_rng);
+        mutate(worker.ga, first_individual, begin, end, probability,
+               chunk_rng);
+        if (!screening)
+          evaluate_changed(worker.ga, worker.cache, worker.tally,
+                           first_individual, first_evaluation, begin, end);
+      });
+    } else {
+      crossover(first_parent, population_size, first_individual, rng);
+      mutate(first_individual, population_size, probability, rng);
+    }
+    if (m_replace_duplicates)
+      replace_duplicates(first_individual, population_size, rng);
+    if (m_max_similarity < 1)
+      reject_similar(first_individual, population_size, first_parent, rng);
+    if (!m_pool)
+      evaluate_changed(first_individual, population_size, first_evaluation);
+    else if (screening)
+      for_each_chunk(population_size, [&](Worker &worker, auto &,
+                                          size_t begin, size_t end) {
+        evaluate_changed(worker.ga, worker.cache, worker.tally,
+                         first_individual, first_evaluation, begin, end);
+      });
+    // Parents received from other processes have no known fitness
+    if (m_parents_evaluated) {
+      double gain = 0;
+      for (size_t i = 0; i < population_size; i++) {
+        gain += double(*snext(first_evaluation, i)) -
+                double(m_parent_evaluations[i]);
+      }
+      credit_mutation_probability(gain / double(population_size));
+    }
   }
 
-  template <typename PopulationIt, typename ParentIt, typename EvaluationsIt,
-            class RNG>
-  void loop_from_parents(PopulationIt first_individual, size_t population_size,
-                         ParentIt first_parent, EvaluationsIt first_evaluation,
-                         size_t n_iterations, double mutation_probability,
-                         RNG &rng) {
-    using namespace indicators;
-    if (n_iterations == 0)
+  // Mutation probability for the next generation: a multiple of the given
+  // one picked by the bandit when the control is adaptive
+  template <class RNG>
+  double next_mutation_probability(double mutation_probability, RNG &rng) {
+    if (!m_adaptive_mutation)
+      return mutation_probability;
+    m_rate = m_rates.choose(rng);
+    m_rate_start = std::chrono::steady_clock::now();
+    return std::min(1., mutation_probability * rate_factors[m_rate]);
+  }
+
+  // Credits the current multiple with the mean fitness gained by the children
+  // over their parents, per second spent breeding them
+  void credit_mutation_probability(double mean_gain) {
+    if (!m_adaptive_mutation)
       return;
-    cross_mut_eval(first_individual, population_size, first_parent,
-                   first_evaluation, mutation_probability, rng);
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - m_rate_start;
+    m_rates.reward(m_rate, mean_gain / std::max(elapsed.count(), 1e-9));
+  }
+
+  inline FitnessMeasure evaluate_cached(const Individual &individual,
+                                        const Hash hash) {
+    return evaluate_cached(m_ga, m_cache, m_tally, individual, hash);
+  }
+
+  static FitnessMeasure
+  evaluate_cached(GA &ga, FitnessCache<Hash, FitnessMeasure> &cache,
+                  Tally &tally, const Individual &individual, const Hash hash) {
+    if (const auto cached = cache.find(hash)) {
+      tally.n_cache_hits++;
+      tally.n_skipped_evaluations++;
+      return *cached;
+    }
+    const auto fitness = ga.evaluate(individual);
+    cache.insert(hash, fitness);
+    tally.n_evaluations++;
+    return fitness;
+  }
+
+  template <typename PopulationIt, typename EvaluationsIt>
+  inline void evaluate_changed(PopulationIt first_individual, size_t N,
+                               EvaluationsIt first_evaluation) {
+    evaluate_changed(m_ga, m_cache, m_tally, first_individual,
+                     first_evaluation, 0, N);
+  }
+
+  // The crossover, mutate and evaluate_changed steps on the individuals from
+  // begin to end, by the given GA, as the workers run them on their slices
+  template <typename PopulationInIt, typename PopulationOutIt, class RNG>
+  void crossover(GA &ga, PopulationInIt first_parent,
+                 PopulationOutIt first_child, size_t begin, size_t end,
+                 RNG &rng) {
+    for (size_t i = begin; i < end; i += 2) {
+      m_hashes[i] = m_parent_hashes[i];
+      m_hashes[i + 1] = m_parent_hashes[i + 1];
+      ga.crossover(*snext(first_parent, m_selected[i]),
+                   *snext(first_parent, m_selected[i + 1]),
+                   *snext(first_child, i), *snext(first_child, i + 1),
+                   m_hashes[i], m_hashes[i + 1], rng);
+      m_changed[i] = !m_parents_evaluated || m_hashes[i] != m_parent_hashes[i];
+      m_changed[i + 1] =
+          !m_parents_evaluated || m_hashes[i + 1] != m_parent_hashes[i + 1];
+    }
+  }
+
+  template <typename PopulationIt, class RNG>
+  void mutate(GA &ga, PopulationIt first_individual, size_t begin,
+              size_t end, double mutation_probability, RNG &rng) {
+    std::uniform_real_distribution<double> mutprob;
+    for (auto i = begin; i < end; i++) {
+      if (mutprob(rng) < mutation_probability) {
+        ga.mutate(*snext(first_individual, i), m_hashes[i], rng);
+        m_changed[i] = true;
+      }
+    }
+  }
+
+  template <typename PopulationIt, typename EvaluationsIt>
+  void evaluate_changed(GA &ga, FitnessCache<Hash, FitnessMeasure> &cache,
+                        Tally &tally, PopulationIt first_individual,
+                        EvaluationsIt first_evaluation, size_t begin,
+                        size_t end) {
+    for (auto i = begin; i < end; i++) {
+      if (m_changed[i]) {
+        *snext(first_evaluation, i) = evaluate_cached(
+            ga, cache, tally, *snext(first_individual, i), m_hashes[i]);
+      } else {
+        *snext(first_evaluation, i) = m_parent_evaluations[i];
+        tally.n_skipped_evaluations++;
+      }
+    }
+  }
+
+  // Runs step(worker, rng, begin, end) on the chunks of the population,
+  // then adds up the counters of the workers. The engine of a chunk only
+  // depends on the seed of the generation and the position of the chunk.
+  template <class Step> void for_each_chunk(size_t N, Step &&step) {
+    m_scheduler->run(N, m_chunk_size, [&](const size_t w, const size_t begin,
+                                          const size_t end) {
+      std::mt19937_64 chunk_rng(splitmix64(m_chunk_seed + begin));
+      step(*m_workers[w], chunk_rng, begin, end);
+    });
+    collect_tallies();
+  }
+
+  // Adds the counters of the workers to those of the process
+  void collect_tallies() {
+    for (auto &worker : m_workers) {
+      m_tally.n_evaluations += worker->tally.n_evaluations;
+      m_tally.n_skipped_evaluations += worker->tally.n_skipped_evaluations;
+      m_tally.n_cache_hits += worker->tally.n_cache_hits;
+      worker->tally = Tally{};
+    }
+  }
+
+  // Draws the seed of the chunk engines of a generation from the engine of
+  // the run
+  template <class RNG> void draw_chunk_seed(RNG &rng) {
+    m_chunk_seed = std::uniform_int_distribution<uint64_t>()(rng);
+  }
+
+  [[nodiscard]] bool pipelined() const { return m_pipelined && m_pool; }
+
+  // Throws if an option that pipelined runs do not apply is set
+  void check_pipelined() const {
+    if (pipelined() && (m_adaptive_mutation || m_max_similarity < 1 ||
+                        m_replace_duplicates))
+      throw std::runtime_error(
+          "Pipelined runs neither adapt the mutation probability nor screen "
+          "the children");
+  }
+
+  // Individuals, evaluations and hashes of one of the two populations of a
+  // pipelined run
+  template <typename PopulationIt, typename EvaluationsIt, typename HashIt>
+  struct Buffers {
+    PopulationIt individuals;
+    EvaluationsIt evaluations;
+    HashIt hashes;
+  };
+
+  // Breeds n_iterations generations of the evaluated population as set by
+  // set_pipelined, alternating between the given buffers and internal ones
+  template <typename PopulationIt, typename EvaluationsIt, class RNG>
+  void pipelined_loop(PopulationIt first_individual, size_t population_size,
+                      EvaluationsIt first_evaluation, size_t n_iterations,
+                      double mutation_probability, RNG &rng) {
+    draw_chunk_seed(rng);
+    auto individuals = allocate<Individual>(population_size);
+    auto evaluations = allocate<FitnessMeasure>(population_size);
+    std::vector<Hash> hashes(population_size);
+    const Buffers<PopulationIt, EvaluationsIt,
+                  typename std::vector<Hash>::iterator>
+        given{first_individual, first_evaluation, m_hashes.begin()};
+    const Buffers<typename decltype(individuals)::iterator,
+                  typename decltype(evaluations)::iterator,
+                  typename std::vector<Hash>::iterator>
+        internal{individuals.begin(), evaluations.begin(), hashes.begin()};
+
+    const auto n_chunks = (population_size + m_chunk_size - 1) / m_chunk_size;
+    const auto first_generation = m_generation;
+    // Workers publish the best child of each chunk as soon as it is bred
+    std::mutex publishing;
+    size_t n_bred = 0;
+    const auto publish_chunk = [&](const auto &bred, const size_t begin,
+                                   const size_t end) {
+      const auto best = std::max_element(snext(bred.evaluations, begin),
+                                         snext(bred.evaluations, end));
+      const auto &individual = *snext(
+          bred.individuals, size_t(std::distance(bred.evaluations, best)));
+      std::lock_guard<std::mutex> lock(publishing);
+      if (*best > m_published.fitness) {
+        m_published.individual = individual;
+        m_published.fitness = *best;
+      }
+      // As many generations as the whole population went through
+      m_published.generation = first_generation - 1 + ++n_bred / n_chunks;
+      m_best.publish(m_published);
+    };
+    const auto n_done = m_scheduler->pipeline(
+        population_size, m_chunk_size, n_iterations, m_radius,
+        [&](const size_t w, const size_t generation, const size_t begin,
+            const size_t end) {
+          std::mt19937_64 chunk_rng(
+              splitmix64(m_chunk_seed + generation * population_size + begin));
+          auto &worker = *m_workers[w];
+          if (generation % 2 == 0) {
+            breed_chunk(worker, given, internal, population_size, begin, end,
+                        mutation_probability, chunk_rng);
+            publish_chunk(internal, begin, end);
+          } else {
+            breed_chunk(worker, internal, given, population_size, begin, end,
+                        mutation_probability, chunk_rng);
+            publish_chunk(given, begin, end);
+          }
+        },
+        [&]() { return m_cancellation.cancelled(); });
+    collect_tallies();
+
+    // Chunks are left at different generations when cancelled: the last one
+    // bred of each is brought back to the given buffers
+    for (size_t chunk = 0; chunk < n_chunks; chunk++) {
+      if (n_done[chunk] % 2 == 0)
+        continue;
+      const auto begin = chunk * m_chunk_size;
+      const auto end = std::min(population_size, begin + m_chunk_size);
+      std::copy(snext(individuals.cbegin(), begin),
+                snext(individuals.cbegin(), end),
+                snext(first_individual, begin));
+      std::copy(snext(evaluations.cbegin(), begin),
+                snext(evaluations.cbegin(), end),
+                snext(first_evaluation, begin));
+      std::copy(snext(hashes.cbegin(), begin), snext(hashes.cbegin(), end),
+                snext(m_hashes.begin(), begin));
+    }
+    m_generation = first_generation - 1 +
+                   *std::min_element(n_done.cbegin(), n_done.cend());
+    publish_best(first_individual, first_evaluation, population_size);
+  }
 
-    for (size_t i = 1; i < n_iterations; i++) {
-      select_parents(first_individual, population_size, first_parent,
-                     first_evaluation, rng);
-      cross_mut_eval(first_individual, population_size, first_parent,
-                     first_evaluation, mutation_probability, rng);
+  // Breeds the chunk from begin to end of a pipelined run into the other
+  // population, from parents selected in its neighbourhood in this one
+  template <class From, class To, class RNG>
+  void breed_chunk(Worker &worker, const From &from, const To &to, size_t N,
+                   size_t begin, size_t end, double mutation_probability,
+                   RNG &rng) {
+    const auto n_chunks = (N + m_chunk_size - 1) / m_chunk_size;
+    const auto width = std::min(2 * m_radius + 1, n_chunks);
+    const auto first_chunk =
+        (begin / m_chunk_size + n_chunks - m_radius % n_chunks) % n_chunks;
+    worker.neighbours.clear();
+    worker.neighbour_evaluations.clear();
+    for (size_t k = 0; k < width; k++) {
+      const auto chunk = (first_chunk + k) % n_chunks;
+      for (auto i = chunk * m_chunk_size;
+           i < std::min(N, (chunk + 1) * m_chunk_size); i++) {
+        worker.neighbours.push_back(i);
+        worker.neighbour_evaluations.push_back(*snext(from.evaluations, i));
+      }
+    }
+    const auto n_neighbours = worker.neighbours.size();
+    worker.selected.resize(n_neighbours);
+    worker.selection.select(worker.ga, worker.neighbour_evaluations.cbegin(),
+                            n_neighbours, worker.selected.begin(), rng);
+    std::shuffle(worker.selected.begin(), worker.selected.end(), rng);
+
+    std::uniform_real_distribution<double> mutprob;
+    for (auto i = begin; i < end; i += 2) {
+      const std::array<size_t, 2> parents{
+          worker.neighbours[worker.selected[i - begin]],
+          worker.neighbours[worker.selected[i - begin + 1]]};
+      std::array<Hash, 2> child_hashes{*snext(from.hashes, parents[0]),
+                                       *snext(from.hashes, parents[1])};
+      worker.ga.crossover(*snext(from.individuals, parents[0]),
+                          *snext(from.individuals, parents[1]),
+                          *snext(to.individuals, i),
+                          *snext(to.individuals, i + 1), child_hashes[0],
+                          child_hashes[1], rng);
+      for (size_t c = 0; c < 2; c++) {
+        auto &child = *snext(to.individuals, i + c);
+        if (mutprob(rng) < mutation_probability)
+          worker.ga.mutate(child, child_hashes[c], rng);
+        if (child_hashes[c] == *snext(from.hashes, parents[c])) {
+          *snext(to.evaluations, i + c) = *snext(from.evaluations, parents[c]);
+          worker.tally.n_skipped_evaluations++;
+        } else {
+          *snext(to.evaluations, i + c) = evaluate_cached(
+              worker.ga, worker.cache, worker.tally, child, child_hashes[c]);
+        }
+        *snext(to.hashes, i + c) = child_hashes[c];
+      }
+    }
+  }
+
+  template <typename PopulationIt, typename EvaluationsIt, class RNG>
+  void steady_state_loop(PopulationIt first_individual, size_t population_size,
+                         EvaluationsIt first_evaluation, size_t n_steps,
+                         double mutation_probability, RNG &rng) {
+    resize_state(population_size);
+    std::uniform_int_distribution<size_t> pick(0, population_size - 1);
+    std::uniform_real_distribution<double> mutprob;
+    auto probability = mutation_probability;
+    // Fitness gained by the children of this generation over their parents
+    double gain = 0;
+    size_t n_children = 0;
+    const auto rejecting = m_max_similarity < 1;
+    if (rejecting)
+      m_edges.assign(first_individual, population_size);
+    // Each step breeds two children
+    const auto steps_per_generation = (population_size + 1) / 2;
+    for (size_t step = 0; step < n_steps; step++) {
+      // Rebuilding once per generation bounds the rounding drift of updates.
+      // Other policies are prepared as often, so ranks may lag behind.
+      if (step % steps_per_generation == 0) {
+        if (step > 0) {
+          publish_best(first_individual, first_evaluation, population_size);
+          if (m_cancellation.cancelled())
+            return;
+        }
+        if constexpr (is_roulette)
+          m_weights.assign(first_evaluation, population_size);
+        else
+          m_selection.prepare(first_evaluation, population_size);
+        if (n_children > 0)
+          credit_mutation_probability(gain / double(n_children));
+        probability = next_mutation_probability(mutation_probability, rng);
+        gain = 0;
+        n_children = 0;
+      }
+
+      std::array<size_t, 2> parents{};
+      for (auto &parent : parents) {
+        if constexpr (is_roulette) {
+          std::uniform_real_distribution<double> roulette(
+              0, double(m_weights.total()));
+          parent = m_weights.find(FitnessMeasure(roulette(rng)));
+        } else {
+          parent = m_selection.select_one(first_evaluation, population_size,
+                                          rng);
+        }
+      }
+      std::array<Hash, 2> hashes{m_hashes[parents[0]], m_hashes[parents[1]]};
+      std::array<Individual, 2> children;
+      m_ga.crossover(*snext(first_individual, parents[0]),
+                     *snext(first_individual, parents[1]), children[0],
+                     children[1], hashes[0], hashes[1], rng);
+      std::array<FitnessMeasure, 2> fitnesses{};
+      std::array<bool, 2> discarded{};
+      for (size_t c = 0; c < 2; c++) {
+        if (mutprob(rng) < probability)
+          m_ga.mutate(children[c], hashes[c], rng);
+        if (rejecting &&
+            m_edges.similarity(children[c]) > m_max_similarity) {
+          fitnesses[c] = *snext(first_evaluation, parents[c]);
+          discarded[c] = true;
+          m_n_rejected_similar++;
+        } else if (hashes[c] == m_hashes[parents[c]]) {
+          fitnesses[c] = *snext(first_evaluation, parents[c]);
+          discarded[c] = m_replace_duplicates;
+          m_tally.n_skipped_evaluations++;
+        } else {
+          fitnesses[c] = evaluate_cached(children[c], hashes[c]);
+        }
+        gain += double(fitnesses[c]) -
+                double(*snext(first_evaluation, parents[c]));
+        n_children++;
+      }
+      // Each child replaces the worse of two random individuals
+      for (size_t c = 0; c < 2; c++) {
+        if (discarded[c])
+          continue;
+        const auto a = pick(rng);
+        const auto b = pick(rng);
+        const auto victim =
+            *snext(first_evaluation, a) < *snext(first_evaluation, b) ? a : b;
+        if (rejecting) {
+          m_edges.remove(*snext(first_individual, victim));
+          m_edges.add(children[c]);
+        }
+        *snext(first_individual, victim) = std::move(children[c]);
+        *snext(first_evaluation, victim) = fitnesses[c];
+        m_hashes[victim] = hashes[c];
+        if constexpr (is_roulette)
+          m_weights.set(victim, fitnesses[c]);
+      }
     }
+    if (n_children > 0)
+      credit_mutation_probability(gain / double(n_children));
+    publish_best(first_individual, first_evaluation, population_size);
   }
 
+  // Breeds the generations alternately into the buffer and back into the
+  // population, from the parents read in place in the other one, so that
+  // each child is written once. The last generation is copied back to the
+  // population if it was bred into the buffer.
   template <typename PopulationIt, typename BufferIt, typename EvaluationsIt,
             class RNG>
-  void loop_from_start(PopulationIt first_individual, size_t population_size,
-                       BufferIt first_buffer, EvaluationsIt first_evaluation,
-                       size_t n_iterations, double mutation_probability,
-                       RNG &rng) {
-    if (n_iterations == 0)
-      return;
-    select_parents(first_individual, population_size, first_buffer,
-                   first_evaluation, rng);
-    loop_from_parents(first_individual, population_size, first_buffer,
-                      first_evaluation, n_iterations, mutation_probability,
-                      rng);
+  void generational_loop(PopulationIt first_individual, size_t population_size,
+                         BufferIt first_buffer, EvaluationsIt first_evaluation,
+                         size_t n_iterations, double mutation_probability,
+                         RNG &rng) {
+    size_t n_bred = 0;
+    for (; n_bred < n_iterations &&
+           (n_bred == 0 || !m_cancellation.cancelled());
+         n_bred++) {
+      if (!m_parents_selected)
+        select(first_evaluation, population_size, rng);
+      if (n_bred % 2 == 0) {
+        cross_mut_eval(first_buffer, population_size, first_individual,
+                       first_evaluation, mutation_probability, rng);
+        publish_best(first_buffer, first_evaluation, population_size);
+      } else {
+        cross_mut_eval(first_individual, population_size, first_buffer,
+                       first_evaluation, mutation_probability, rng);
+        publish_best(first_individual, first_evaluation, population_size);
+      }
+    }
+    if (n_bred % 2 == 1)
+      std::copy(first_buffer, snext(first_buffer, population_size),
+                first_individual);
   }
 };
 } // namespace genetic
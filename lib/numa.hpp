@@ -0,0 +1,144 @@
+#ifndef GENETIC_TSP_NUMA_HPP
+#define GENETIC_TSP_NUMA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Placement of threads and memory on NUMA nodes, without libnuma: Linux
+// allocates a page on the node of the thread that first writes it, so data
+// is made local by having the thread that will read it initialise it.
+namespace genetic::numa {
+
+struct Topology {
+  // CPUs of each node that the process may run on
+  std::vector<std::vector<int>> node_cpus;
+
+  [[nodiscard]] size_t n_nodes() const { return node_cpus.size(); }
+
+  // Only the given node, to place threads on it alone
+  [[nodiscard]] Topology restricted_to(size_t node) const {
+    return Topology{{node_cpus.at(node)}};
+  }
+
+  // Read from /sys, falling back to a single node holding one CPU per
+  // hardware thread
+  static Topology detect() {
+    Topology topology;
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    const auto known = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    for (size_t node = 0;; node++) {
+      std::ifstream file("/sys/devices/system/node/node" +
+                         std::to_string(node) + "/cpulist");
+      if (!file)
+        break;
+      std::string list;
+      std::getline(file, list);
+      std::vector<int> cpus;
+      for (const auto cpu : parse_cpu_list(list)) {
+        if (!known || CPU_ISSET(cpu, &allowed))
+          cpus.push_back(cpu);
+      }
+      if (!cpus.empty())
+        topology.node_cpus.push_back(std::move(cpus));
+    }
+#endif
+    if (topology.node_cpus.empty()) {
+      std::vector<int> cpus(
+          std::max(std::thread::hardware_concurrency(), 1U));
+      for (size_t cpu = 0; cpu < cpus.size(); cpu++) {
+        cpus[cpu] = int(cpu);
+      }
+      topology.node_cpus.push_back(std::move(cpus));
+    }
+    return topology;
+  }
+
+  // Ranges such as "0-3,8,10-11"
+  static std::vector<int> parse_cpu_list(const std::string &list) {
+    std::vector<int> cpus;
+    std::stringstream ranges(list);
+    for (std::string range; std::getline(ranges, range, ',');) {
+      if (range.empty())
+        continue;
+      const auto dash = range.find('-');
+      const auto first = std::stoi(range.substr(0, dash));
+      const auto last = dash == std::string::npos
+                            ? first
+                            : std::stoi(range.substr(dash + 1));
+      for (auto cpu = first; cpu <= last; cpu++) {
+        cpus.push_back(cpu);
+      }
+    }
+    return cpus;
+  }
+};
+
+struct Place {
+  size_t node;
+  int cpu;
+};
+
+// Places n_threads threads in contiguous runs over the nodes, as evenly as
+// possible, and over the CPUs of each node in turn. Contiguous runs keep
+// neighbouring slices of the data of the threads on the same node.
+inline std::vector<Place> spread(size_t n_threads, const Topology &topology) {
+  std::vector<Place> places(n_threads);
+  std::vector<size_t> n_placed(topology.n_nodes(), 0);
+  for (size_t t = 0; t < n_threads; t++) {
+    const auto node = t * topology.n_nodes() / n_threads;
+    const auto &cpus = topology.node_cpus[node];
+    places[t] = Place{node, cpus[n_placed[node]++ % cpus.size()]};
+  }
+  return places;
+}
+
+// Best effort: returns false where unsupported or not allowed
+inline bool pin_current_thread(int cpu) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)cpu;
+  return false;
+#endif
+}
+
+// Allocator leaving default-constructed values uninitialised, so that
+// allocating a vector of trivial values does not touch its pages
+template <typename T> struct DefaultInitAllocator : std::allocator<T> {
+  template <typename U> struct rebind {
+    using other = DefaultInitAllocator<U>;
+  };
+  using std::allocator<T>::allocator;
+
+  template <typename U> void construct(U *p) {
+    ::new (static_cast<void *>(p)) U;
+  }
+  template <typename U, typename... Args>
+  void construct(U *p, Args &&...args) {
+    ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+  }
+};
+
+template <typename T>
+using FirstTouchVector = std::vector<T, DefaultInitAllocator<T>>;
+} // namespace genetic::numa
+
+#endif // GENETIC_TSP_NUMA_HPP
@@ -0,0 +1,212 @@
+#ifndef GENETIC_TSP_SCHEDULER_HPP
+#define GENETIC_TSP_SCHEDULER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+namespace genetic {
+
+// Work stealing over the workers of a ThreadPool, for items whose costs
+// differ widely. A range of items is cut into chunks, and each worker is
+// first given the chunks of its own slice of the range, as by
+// ThreadPool::slice, so that it works on the data it first touched. It
+// takes them from the front of its deque, in order, and once it runs out
+// steals from the back of the deques of the others. Chunks are coarse, so a
+// mutex per deque costs little.
+class Scheduler {
+public:
+  // Time spent and chunks run by a worker, since construction or reset
+  struct WorkerStats {
+    double busy_seconds{0};
+    size_t n_chunks{0};
+    // Chunks taken from the deque of another worker
+    size_t n_stolen{0};
+  };
+
+  explicit Scheduler(ThreadPool &pool)
+      : m_pool(pool), m_queues(pool.size()), m_stats(pool.size()) {}
+
+  // Calls task(worker, begin, end) on consecutive chunks of chunk_size
+  // items covering [0, N), the last one possibly shorter, and waits for all
+  // of them
+  template <class Task> void run(size_t N, size_t chunk_size, Task &&task) {
+    chunk_size = std::max(chunk_size, size_t(1));
+    const auto n_chunks = (N + chunk_size - 1) / chunk_size;
+    for (size_t w = 0; w < m_queues.size(); w++) {
+      const auto [begin, end] = m_pool.slice(w, n_chunks);
+      auto &chunks = m_queues[w].chunks;
+      chunks.clear();
+      for (auto c = begin; c < end; c++) {
+        chunks.push_back(c);
+      }
+    }
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    m_pool.run([&](const size_t w) {
+      auto &stats = m_stats[w];
+      while (true) {
+        auto chunk = pop(w);
+        const auto stolen = !chunk;
+        if (stolen)
+          chunk = steal(w);
+        if (!chunk)
+          return;
+        const auto chunk_start = clock::now();
+        task(w, *chunk * chunk_size, std::min(N, (*chunk + 1) * chunk_size));
+        const std::chrono::duration<double> busy = clock::now() - chunk_start;
+        stats.busy_seconds += busy.count();
+        stats.n_chunks++;
+        stats.n_stolen += stolen ? 1 : 0;
+      }
+    });
+    const std::chrono::duration<double> elapsed = clock::now() - start;
+    m_wall_seconds += elapsed.count();
+  }
+
+  // Runs n_steps steps over the same chunks, calling task(worker, step,
+  // begin, end), with no barrier between steps: step s of a chunk may start
+  // once the chunks within radius of it, around the range taken as a ring,
+  // have completed step s - 1. Workers thus go on with the next step of some
+  // chunks while others are still at the previous one, and neighbouring
+  // chunks are never more than one step apart. Each worker takes ready
+  // chunks of its own slice first, then any other one, counted as stolen.
+  // No step is started once stop() returns true. Returns the number of
+  // steps completed by each chunk.
+  template <class Task, class Stop>
+  std::vector<size_t> pipeline(size_t N, size_t chunk_size, size_t n_steps,
+                               size_t radius, Task &&task, Stop &&stop) {
+    chunk_size = std::max(chunk_size, size_t(1));
+    const auto n_chunks = (N + chunk_size - 1) / chunk_size;
+    struct Stage {
+      std::atomic<size_t> n_done{0};
+      std::atomic<bool> busy{false};
+    };
+    std::vector<Stage> stages(n_chunks);
+    const auto ready = [&](const size_t chunk, const size_t step) {
+      for (size_t k = 1; k <= radius && k < n_chunks; k++) {
+        if (stages[(chunk + k) % n_chunks].n_done.load(
+                std::memory_order_acquire) < step ||
+            stages[(chunk + n_chunks - k) % n_chunks].n_done.load(
+                std::memory_order_acquire) < step)
+          return false;
+      }
+      return true;
+    };
+    // Set when a task throws, as its chunk will never be done
+    std::atomic<bool> failed{false};
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    m_pool.run([&](const size_t w) {
+      auto &stats = m_stats[w];
+      const auto [own_begin, own_end] = m_pool.slice(w, n_chunks);
+      while (!failed.load(std::memory_order_relaxed) && !stop()) {
+        auto pending = false;
+        auto ran = false;
+        for (size_t k = 0; k < n_chunks && !ran; k++) {
+          const auto chunk = (own_begin + k) % n_chunks;
+          auto &stage = stages[chunk];
+          const auto step = stage.n_done.load(std::memory_order_acquire);
+          if (step >= n_steps)
+            continue;
+          pending = true;
+          if (!ready(chunk, step) ||
+              stage.busy.exchange(true, std::memory_order_acquire))
+            continue;
+          // Another worker may have run the step in between
+          if (stage.n_done.load(std::memory_order_relaxed) == step) {
+            const auto chunk_start = clock::now();
+            try {
+              task(w, step, chunk * chunk_size,
+                   std::min(N, (chunk + 1) * chunk_size));
+            } catch (...) {
+              failed.store(true, std::memory_order_relaxed);
+              throw;
+            }
+            const std::chrono::duration<double> busy =
+                clock::now() - chunk_start;
+            stage.n_done.store(step + 1, std::memory_order_release);
+            stats.busy_seconds += busy.count();
+            stats.n_chunks++;
+            stats.n_stolen += chunk < own_begin || chunk >= own_end ? 1 : 0;
+            ran = true;
+          }
+          stage.busy.store(false, std::memory_order_release);
+        }
+        if (!pending)
+          return;
+        if (!ran)
+          std::this_thread::yield();
+      }
+    });
+    const std::chrono::duration<double> elapsed = clock::now() - start;
+    m_wall_seconds += elapsed.count();
+    std::vector<size_t> n_done(n_chunks);
+    for (size_t chunk = 0; chunk < n_chunks; chunk++) {
+      n_done[chunk] = stages[chunk].n_done.load(std::memory_order_relaxed);
+    }
+    return n_done;
+  }
+
+  [[nodiscard]] size_t size() const { return m_stats.size(); }
+  [[nodiscard]] const std::vector<WorkerStats> &stats() const {
+    return m_stats;
+  }
+  // Time spent in run, during which every worker was either busy or idle
+  [[nodiscard]] double wall_seconds() const { return m_wall_seconds; }
+  // Fraction of the time in run that the worker spent on chunks
+  [[nodiscard]] double utilisation(size_t worker) const {
+    return m_wall_seconds > 0 ? m_stats[worker].busy_seconds / m_wall_seconds
+                              : 0;
+  }
+  void reset_stats() {
+    std::fill(m_stats.begin(), m_stats.end(), WorkerStats{});
+    m_wall_seconds = 0;
+  }
+
+private:
+  struct Queue {
+    std::mutex mutex{};
+    std::deque<size_t> chunks{};
+  };
+  ThreadPool &m_pool;
+  std::vector<Queue> m_queues;
+  std::vector<WorkerStats> m_stats;
+  double m_wall_seconds{0};
+
+  std::optional<size_t> pop(const size_t worker) {
+    auto &queue = m_queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.chunks.empty())
+      return std::nullopt;
+    const auto chunk = queue.chunks.front();
+    queue.chunks.pop_front();
+    return chunk;
+  }
+
+  // No chunk is added during a run, so a worker finding every deque empty
+  // is done
+  std::optional<size_t> steal(const size_t thief) {
+    for (size_t k = 1; k < m_queues.size(); k++) {
+      auto &queue = m_queues[(thief + k) % m_queues.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.chunks.empty())
+        continue;
+      const auto chunk = queue.chunks.back();
+      queue.chunks.pop_back();
+      return chunk;
+    }
+    return std::nullopt;
+  }
+};
+} // namespace genetic
+
+#endif // GENETIC_TSP_SCHEDULER_HPP
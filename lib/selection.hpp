@@ -0,0 +1,130 @@
+#ifndef GENETIC_TSP_SELECTION_HPP
+#define GENETIC_TSP_SELECTION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "utils.hpp"
+
+// Parent selection policies for genetic::Process. Each policy turns the
+// evaluations of a population (or of any slice of it) into the indices of
+// the selected parents: prepare() runs once per generation, select_one()
+// draws a single parent.
+namespace genetic::selection {
+
+// Fitness-proportional selection, delegated to GA::select_parents. It needs
+// the cumulative sum of the whole range, so it has no select_one: the
+// steady-state mode samples it from a FenwickTree instead.
+class Roulette {
+public:
+  template <typename EvaluationsIt>
+  void prepare(EvaluationsIt /*first_evaluation*/, size_t N) {
+    if (m_indices.size() != N) {
+      m_indices.resize(N);
+      std::iota(m_indices.begin(), m_indices.end(), 0);
+    }
+  }
+
+  template <class GA, typename EvaluationsIt, typename SelectedIt, class RNG>
+  void select(GA &ga, EvaluationsIt first_evaluation, size_t N,
+              SelectedIt first_selected, RNG &rng) {
+    prepare(first_evaluation, N);
+    ga.select_parents(m_indices.cbegin(), N, first_selected, first_evaluation,
+                      rng);
+  }
+
+private:
+  std::vector<size_t> m_indices{};
+};
+
+// The fittest of k individuals drawn uniformly: O(k) per parent and
+// independent of the fitness scale.
+class Tournament {
+public:
+  explicit Tournament(size_t k = 2) : m_k(std::max(k, size_t(1))) {}
+
+  template <typename EvaluationsIt>
+  void prepare(EvaluationsIt /*first_evaluation*/, size_t /*N*/) {}
+
+  template <typename EvaluationsIt, class RNG>
+  size_t select_one(EvaluationsIt first_evaluation, size_t N, RNG &rng) {
+    std::uniform_int_distribution<size_t> pick(0, N - 1);
+    auto best = pick(rng);
+    for (size_t i = 1; i < m_k; i++) {
+      const auto contender = pick(rng);
+      if (*snext(first_evaluation, contender) > *snext(first_evaluation, best))
+        best = contender;
+    }
+    return best;
+  }
+
+  template <class GA, typename EvaluationsIt, typename SelectedIt, class RNG>
+  void select(GA & /*ga*/, EvaluationsIt first_evaluation, size_t N,
+              SelectedIt first_selected, RNG &rng) {
+    std::generate(first_selected, snext(first_selected, N),
+                  [&]() { return select_one(first_evaluation, N, rng); });
+  }
+
+private:
+  size_t m_k;
+};
+
+// Linear ranking: the probability of the individual of rank r (0 being the
+// worst) grows linearly from (2 - pressure) / N to pressure / N. prepare()
+// sorts the range, then each parent is drawn in O(1) by inverting the
+// cumulative distribution.
+class LinearRank {
+public:
+  explicit LinearRank(double pressure = 1.5)
+      : m_pressure(std::clamp(pressure, 1., 2.)) {}
+
+  template <typename EvaluationsIt>
+  void prepare(EvaluationsIt first_evaluation, size_t N) {
+    m_order.resize(N);
+    argsort_n(first_evaluation, N, m_order.begin());
+  }
+
+  template <typename EvaluationsIt, class RNG>
+  size_t select_one(EvaluationsIt /*first_evaluation*/, size_t N, RNG &rng) {
+    if (N == 1)
+      return m_order[0];
+    // The CDF (r + 1) (b + a r) is quadratic in the rank r: the root of
+    // CDF = u is off the sampled rank by at most one
+    const auto u = m_uniform(rng);
+    const auto a = (m_pressure - 1) / double(N * (N - 1));
+    const auto b = (2 - m_pressure) / double(N);
+    const auto cdf = [&](const size_t r) {
+      return double(r + 1) * (b + a * double(r));
+    };
+    const auto root =
+        a > 0 ? (std::sqrt((a + b) * (a + b) - 4 * a * (b - u)) - (a + b)) /
+                    (2 * a)
+              : u / b - 1;
+    auto r = size_t(std::clamp(std::ceil(root), 0., double(N - 1)));
+    while (r > 0 && cdf(r - 1) > u)
+      r--;
+    while (r < N - 1 && cdf(r) <= u)
+      r++;
+    return m_order[r];
+  }
+
+  template <class GA, typename EvaluationsIt, typename SelectedIt, class RNG>
+  void select(GA & /*ga*/, EvaluationsIt first_evaluation, size_t N,
+              SelectedIt first_selected, RNG &rng) {
+    prepare(first_evaluation, N);
+    std::generate(first_selected, snext(first_selected, N),
+                  [&]() { return select_one(first_evaluation, N, rng); });
+  }
+
+private:
+  double m_pressure;
+  std::vector<size_t> m_order{};
+  std::uniform_real_distribution<double> m_uniform{};
+};
+} // namespace genetic::selection
+
+#endif // GENETIC_TSP_SELECTION_HPP
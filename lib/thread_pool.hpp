@@ -0,0 +1,135 @@
+#ifndef GENETIC_TSP_THREAD_POOL_HPP
+#define GENETIC_TSP_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "numa.hpp"
+#include "utils.hpp"
+
+namespace genetic {
+
+// Fixed set of worker threads, each pinned to a CPU as placed by
+// numa::spread, running one task at a time on all of them
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t n_threads,
+                      const numa::Topology &topology = numa::Topology::detect())
+      : m_places(numa::spread(std::max(n_threads, size_t(1)), topology)) {
+    for (size_t w = 0; w < m_places.size(); w++) {
+      m_threads.emplace_back([this, w]() {
+        numa::pin_current_thread(m_places[w].cpu);
+        work(w);
+      });
+    }
+  }
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopping = true;
+    }
+    m_start.notify_all();
+    for (auto &thread : m_threads) {
+      thread.join();
+    }
+  }
+
+  [[nodiscard]] size_t size() const { return m_places.size(); }
+  [[nodiscard]] size_t node(size_t worker) const {
+    return m_places[worker].node;
+  }
+  // First worker on the node of the given one
+  [[nodiscard]] size_t leader(size_t worker) const {
+    auto first = worker;
+    while (first > 0 && node(first - 1) == node(worker)) {
+      first--;
+    }
+    return first;
+  }
+
+  // Calls task(worker) on every worker and waits for all of them. The first
+  // exception thrown by a task is rethrown here.
+  template <class Task> void run(Task &&task) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_task = [&task](const size_t worker) { task(worker); };
+    m_pending = size();
+    m_round++;
+    m_start.notify_all();
+    m_done.wait(lock, [&]() { return m_pending == 0; });
+    m_task = nullptr;
+    if (m_error)
+      std::rethrow_exception(std::exchange(m_error, nullptr));
+  }
+
+  // Range of the N items owned by a worker, in whole groups of grain items
+  // but for the remainder, which goes to the last worker
+  [[nodiscard]] std::pair<size_t, size_t> slice(size_t worker, size_t N,
+                                                size_t grain = 1) const {
+    const auto n_groups = N / grain;
+    const auto begin = grain * (worker * n_groups / size());
+    const auto end =
+        worker + 1 == size() ? N : grain * ((worker + 1) * n_groups / size());
+    return {begin, end};
+  }
+
+  // N values, of which each worker value-initialises its slice: by first
+  // touch, the pages of a slice end up on the node of its worker
+  template <typename T>
+  numa::FirstTouchVector<T> allocate(size_t N, size_t grain = 1) {
+    numa::FirstTouchVector<T> values(N);
+    run([&](const size_t worker) {
+      const auto [begin, end] = slice(worker, N, grain);
+      std::fill(snext(values.begin(), begin), snext(values.begin(), end),
+                T{});
+    });
+    return values;
+  }
+
+private:
+  std::vector<numa::Place> m_places;
+  std::vector<std::thread> m_threads{};
+  std::mutex m_mutex{};
+  std::condition_variable m_start{};
+  std::condition_variable m_done{};
+  std::function<void(size_t)> m_task{};
+  size_t m_round{0};
+  size_t m_pending{0};
+  bool m_stopping{false};
+  std::exception_ptr m_error{};
+
+  void work(const size_t worker) {
+    size_t round = 0;
+    while (true) {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_start.wait(lock, [&]() { return m_stopping || m_round != round; });
+      if (m_stopping)
+        return;
+      round = m_round;
+      const auto &task = m_task;
+      lock.unlock();
+      try {
+        task(worker);
+      } catch (...) {
+        lock.lock();
+        if (!m_error)
+          m_error = std::current_exception();
+        lock.unlock();
+      }
+      lock.lock();
+      if (--m_pending == 0)
+        m_done.notify_one();
+    }
+  }
+};
+} // namespace genetic
+
+#endif // GENETIC_TSP_THREAD_POOL_HPP
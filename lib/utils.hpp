@@ -6,6 +6,7 @@
 #define GENETIC_TSP_UTILS_HPP
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <istream>
 #include <iterator>
@@ -20,6 +21,14 @@ template <typename It> inline constexpr auto snext(It it, size_t N) {
   return std::next(it, static_cast<diff_t>(N));
 }
 
+// Stafford's mix13 finalizer: a cheap, well spread 64 bit hash of an integer
+constexpr inline uint64_t splitmix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27U)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31U);
+}
+
 template <typename InputIt, typename OutputIt, typename Compare>
 constexpr auto argsort(InputIt first, InputIt last, OutputIt indices_first,
                        Compare compare) {
@@ -54,6 +63,30 @@ constexpr inline auto argsort_n(InputIt first, size_t N,
   return argsort(first, snext(first, N), indices_first);
 }
 
+// Indices of the k first elements according to compare, in order, without
+// sorting the rest. The indices range must hold N elements.
+template <typename InputIt, typename OutputIt, typename Compare>
+constexpr auto argpartial_sort_n(InputIt first, size_t N, size_t k,
+                                 OutputIt indices_first, Compare compare) {
+  using diff_t = typename std::iterator_traits<InputIt>::difference_type;
+  const auto indices_last = snext(indices_first, N);
+  const auto indices_kth = snext(indices_first, std::min(k, N));
+  const auto by_value = [&](const auto left, const auto right) -> bool {
+    return compare(*std::next(first, diff_t(left)),
+                   *std::next(first, diff_t(right)));
+  };
+  std::iota(indices_first, indices_last, 0);
+  if (indices_kth != indices_last)
+    std::nth_element(indices_first, indices_kth, indices_last, by_value);
+  std::sort(indices_first, indices_kth, by_value);
+}
+
+template <typename InputIt, typename OutputIt>
+constexpr inline auto argpartial_sort_n(InputIt first, size_t N, size_t k,
+                                        OutputIt indices_first) {
+  return argpartial_sort_n(first, N, k, indices_first, std::less<>());
+}
+
 template <typename InputIt, typename OrderIt>
 constexpr inline auto order_by_n(InputIt first, size_t N,
                                  OrderIt indices_first) {
@@ -63,28 +63,29 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char *argv[]) {
   std::array<point, N_CITIES> coordinates;
   make_circle_points(1., coordinates.begin(), N_CITIES);
 
-  TSP<point, N_CITIES> ga(coordinates);
+  using Problem = TSP<point, N_CITIES>;
+  Problem ga(coordinates);
   genetic::Process gp(std::move(ga));
 
-  using Individual = typename TSP<point, N_CITIES>::Individual;
+  using Individual = typename Problem::Individual;
+  using FitnessMeasure = typename Problem::FitnessMeasure;
   CONTAINER(Individual, population){};
-  CONTAINER(double, evaluations){};
+  CONTAINER(FitnessMeasure, evaluations){};
 
   gp.mpi_run(population.begin(), POPULATION_SIZE, evaluations.begin(), N_ITER,
              N_BLOCKS, 0.05, rng);
 
   if (process_rank == 0) {
-    std::vector<int> ranks(POPULATION_SIZE);
-    rank(evaluations.cbegin(), evaluations.cend(), ranks.begin(),
-         std::greater<>());
-    order_by(population.begin(), population.end(), ranks.cbegin());
-    order_by(evaluations.begin(), evaluations.end(), ranks.cbegin());
+    const auto n_best = std::min(50ULL, POPULATION_SIZE);
+    std::vector<size_t> best(POPULATION_SIZE);
+    argpartial_sort_n(evaluations.cbegin(), POPULATION_SIZE, n_best,
+                      best.begin(), std::greater<>());
 
-    for (size_t i = 0; i < std::min(50ULL, POPULATION_SIZE); i++) {
-      for (auto j : population[i]) {
+    for (size_t i = 0; i < n_best; i++) {
+      for (auto j : population[best[i]]) {
         std::cout << j << ' ';
       }
-      std::cout << '\t' << evaluations[i] << '\n';
+      std::cout << '\t' << evaluations[best[i]] << '\n';
     }
   }
 #ifdef USE_MPI
@@ -1,5 +1,8 @@
+#include <array>
+#include <csignal>
 #include <fstream>
-#include <valarray>
+#include <map>
+#include <string>
 #include <vector>
 
 #include <cxxopts.hpp>
@@ -11,22 +14,50 @@
 
 #include "ariel_random.hpp"
 #include "config.hpp"
+#include "genetic_algorithms/buckets.hpp"
+#include "genetic_algorithms/instance.hpp"
+#include "genetic_algorithms/renumbering.hpp"
+#include "genetic_algorithms/service.hpp"
 #include "genetic_algorithms/tsp_ga.hpp"
+#include "genetic_algorithms/warm_start.hpp"
 #include "genetic_process.hpp"
+#include "numa.hpp"
 #include "utils.hpp"
 
-#define N_CITIES 50UL
-
 namespace csv = rapidcsv;
 
+namespace {
+// Ctrl-C ends the run after the current block, which is then saved
+genetic::CancellationToken interrupted;
+void interrupt(int) { interrupted.cancel(); }
+} // namespace
+
 int main(int argc, char *argv[]) {
   cxxopts::Options options("Exercise 10.2", "How to run exercise 10.2");
   using cxxopts::value;
   // clang-format off
   options.add_options()
+      ("f,file", "Instance: a TSPLIB .tsp file, or a CSV file with longitude and latitude columns", value<std::string>()->default_value(TSP_PATH "American_capitals.csv"))
       ("m,n_iterations", "Number of iterations per block", value<size_t>()->default_value("6000"))
       ("n,n_recomb", "Number of recombinations", value<size_t>()->default_value("20"))
       ("p,population_size", "Population size", value<size_t>()->default_value("1000"))
+      ("d,replace_duplicates", "Mutate duplicate individuals before evaluating them", value<bool>()->default_value("false"))
+      ("M,max_similarity", "Reject children sharing more than this fraction of edges with the population on average", value<double>()->default_value("1"))
+      ("s,steady_state", "Replace a pair of individuals per step instead of whole generations", value<bool>()->default_value("false"))
+      ("i,seeding", "Initial population: random, nn, greedy or hilbert", value<std::string>()->default_value("random"))
+      ("l,local_search", "Random 2-opt moves tried after each mutation", value<size_t>()->default_value("0"))
+      ("g,gap", "Stop once the best path is within this relative gap of the Held-Karp bound, 0 to not compute the bound", value<double>()->default_value("0"))
+      ("w,stagnation_window", "Blocks without improvement before acting on stagnation, 0 to never act", value<size_t>()->default_value("0"))
+      ("R,on_stagnation", "What to do on stagnation: stop or restart", value<std::string>()->default_value("stop"))
+      ("A,adaptive", "Adapt the mutation operators and probability to their payoff", value<bool>()->default_value("false"))
+      ("W,warm_start", "Seed from the best path of a previous p_2fit.csv output", value<std::string>())
+      ("P,previous_file", "Instance of the warm start path, if it differs from the current one", value<std::string>())
+      ("H,hilbert_renumbering", "Renumber the cities along a Hilbert curve while solving", value<bool>()->default_value("false"))
+      ("S,selection", "Parent selection: roulette, tournament or rank", value<std::string>()->default_value("roulette"))
+      ("t,threads", "Worker threads per process breeding and evaluating the population", value<size_t>()->default_value("1"))
+      ("o,pipelined", "Pipeline the generations of the threads, selecting parents within this many chunks, 0 to breed whole generations, not with -d, -M or -A", value<size_t>()->default_value("0"))
+      ("k,tournament_size", "Individuals per tournament", value<size_t>()->default_value("3"))
+      ("r,rank_pressure", "Linear ranking selection pressure, between 1 and 2", value<double>()->default_value("1.5"))
       ("h,help", "Print this message");
   // clang-format on
   auto result = options.parse(argc, argv);
@@ -55,47 +86,237 @@ int main(int argc, char *argv[]) {
           size_t(process_rank));
   //  std::minstd_rand rng((unsigned(process_rank)));
 
-  using point = std::valarray<double>;
-  std::array<point, N_CITIES> coordinates;
-  csv::Document capitals(TSP_PATH "American_capitals.csv");
-  const auto longitudes = capitals.GetColumn<double>("longitude");
-  const auto latitudes = capitals.GetColumn<double>("latitude");
-  std::transform(longitudes.cbegin(), longitudes.cend(), latitudes.cbegin(),
-                 coordinates.begin(), [](const auto lon, const auto lat) {
-                   return point{lon, lat};
-                 });
+  // CSV points are (longitude, latitude) pairs, measured by great circles.
+  // TSPLIB instances come with their own distance matrix.
+  const auto path = result["f"].as<std::string>();
+  const auto instance = instance::load(path);
+  const auto n_cities = instance.size();
+  auto coordinates = instance.coordinates;
 
-  TSP<point, N_CITIES> ga(coordinates);
-  genetic::Process gp(std::move(ga));
+  std::vector<size_t> new_to_old;
+  if (result["H"].as<bool>()) {
+    new_to_old = renumbering::hilbert(coordinates.cbegin(), n_cities);
+    const auto original = coordinates;
+    renumbering::apply(original.cbegin(), new_to_old, coordinates.begin());
+  }
+  // The N x N matrix of a TSPLIB instance, in the order of coordinates. It
+  // is only built once the instance fits a bucket.
+  const auto tsplib_distances = [&]() {
+    if (instance.edge_weight_type.empty())
+      return std::vector<double>();
+    auto distances = instance.distances();
+    if (!new_to_old.empty()) {
+      const auto original_distances = distances;
+      for (size_t x = 0; x < n_cities; x++) {
+        for (size_t y = 0; y < n_cities; y++) {
+          distances[x * n_cities + y] =
+              original_distances[new_to_old[x] * n_cities + new_to_old[y]];
+        }
+      }
+    }
+    return distances;
+  };
 
-  using Individual = typename TSP<point, N_CITIES>::Individual;
-  std::vector<Individual> population(POPULATION_SIZE);
-  std::vector<double> evaluations(POPULATION_SIZE);
+  // The previous cities that are left are matched by their coordinates
+  std::vector<size_t> warm_tour;
+  instance::Instance previous;
+  std::vector<size_t> previous_match;
+  if (result.count("W")) {
+    previous = instance::load(
+        result.count("P") ? result["P"].as<std::string>() : path);
+    const csv::Document previous_solution(result["W"].as<std::string>(),
+                                          csv::LabelParams(-1, -1));
+    auto previous_tour = previous_solution.GetRow<size_t>(0);
+    previous_tour.insert(previous_tour.begin(), 0);
+    const auto match =
+        warm_start::match(previous.coordinates.cbegin(), previous.size(),
+                          instance.coordinates.cbegin(), instance.size());
+    warm_tour = warm_start::carry_over(previous_tour, match);
+    previous_match = match;
+    if (!new_to_old.empty()) {
+      renumbering::renumber(warm_tour.begin(), warm_tour.end(), new_to_old);
+      for (size_t x = 0; x < n_cities; x++) {
+        previous_match[x] = match[new_to_old[x]];
+      }
+    }
+  }
 
-  gp.mpi_run(population.begin(), POPULATION_SIZE, evaluations.begin(), N_ITER,
-             N_BLOCKS, 0.05, rng);
+  const auto stagnation = result["R"].as<std::string>();
+  if (stagnation != "stop" && stagnation != "restart") {
+    throw std::runtime_error("Unknown stagnation action: " + stagnation);
+  }
 
-  if (process_rank == 0) {
-    std::vector<int> ranks(POPULATION_SIZE);
-    rank(evaluations.cbegin(), evaluations.cend(), ranks.begin(),
-         std::greater<>());
-    order_by(population.begin(), population.end(), ranks.cbegin());
-    order_by(evaluations.begin(), evaluations.end(), ranks.cbegin());
-
-    for (size_t i = 0; i < std::min(50UL, POPULATION_SIZE); i++) {
-      for (auto j : population[i]) {
-        std::cout << j << ' ';
+  // The TSP is instantiated for the smallest bucket holding the instance
+  const auto run = [&](auto bucket) {
+    constexpr size_t SIZE = decltype(bucket)::value;
+    using point = std::array<double, 2>;
+    using Problem = TSP<point, SIZE, metrics::GreatCircle>;
+    using Individual = typename Problem::Individual;
+    using FitnessMeasure = typename Problem::FitnessMeasure;
+    genetic::numa::FirstTouchVector<Individual> population;
+    genetic::numa::FirstTouchVector<FitnessMeasure> evaluations;
+
+    const std::map<std::string, typename Problem::Seeding> seedings{
+        {"random", Problem::Seeding::random},
+        {"nn", Problem::Seeding::nearest_neighbour},
+        {"greedy", Problem::Seeding::greedy},
+        {"hilbert", Problem::Seeding::hilbert}};
+    const auto seeding = seedings.find(result["i"].as<std::string>());
+    if (seeding == seedings.cend()) {
+      throw std::runtime_error("Unknown seeding: " +
+                               result["i"].as<std::string>());
+    }
+
+    // Distances between cities of the previous instance are carried over
+    // from its table, unless the instances come with their own matrices
+    const auto carried =
+        !previous_match.empty() && instance.edge_weight_type.empty() &&
+        previous.edge_weight_type.empty() && previous.size() <= SIZE;
+    const auto problem = [&]() {
+      if (!carried)
+        return Problem(coordinates, tsplib_distances());
+      const Problem previous_problem(previous.coordinates,
+                                     std::vector<double>());
+      return Problem(coordinates, previous_problem, previous_match);
+    };
+
+    const auto solve = [&](auto selection) {
+      auto ga = problem();
+      ga.set_seeding(seeding->second);
+      if (!warm_tour.empty())
+        ga.set_warm_start(warm_tour);
+      ga.set_local_search(result["l"].as<size_t>());
+      ga.set_adaptive_operators(result["A"].as<bool>());
+      // The bound costs O(N^2) per iteration, only paid for a gap target
+      const auto target_gap = result["g"].as<double>();
+      const auto lower_bound = target_gap > 0 ? ga.lower_bound() : 0.;
+      if (process_rank == 0 && target_gap > 0)
+        std::cout << "Held-Karp lower bound: " << lower_bound << '\n';
+      genetic::Process gp(std::move(ga), std::move(selection));
+      using Stagnation = typename decltype(gp)::Stagnation;
+      const auto on_stagnation =
+          stagnation == "stop" ? Stagnation::stop : Stagnation::restart;
+      if (target_gap > 0)
+        gp.set_stop_gap(Problem::fitness_of(lower_bound), target_gap);
+      gp.set_stagnation(result["w"].as<size_t>(), on_stagnation);
+      gp.set_replace_duplicates(result["d"].as<bool>());
+      gp.set_steady_state(result["s"].as<bool>());
+      gp.set_max_similarity(result["M"].as<double>());
+      gp.set_adaptive_mutation(result["A"].as<bool>());
+      gp.set_cancellation(interrupted);
+      // Each worker first touches the slice of the population it breeds
+      gp.set_threads(result["t"].as<size_t>());
+      gp.set_pipelined(result["o"].as<size_t>() > 0, result["o"].as<size_t>());
+      population = gp.template allocate<Individual>(POPULATION_SIZE);
+      evaluations = gp.template allocate<FitnessMeasure>(POPULATION_SIZE);
+      std::signal(SIGINT, interrupt);
+
+      gp.mpi_run(population.begin(), POPULATION_SIZE, evaluations.begin(),
+                 N_ITER, N_BLOCKS, 0.05, rng);
+
+      std::cout << "Process " << process_rank << " skipped "
+                << gp.n_skipped_evaluations() << " of "
+                << gp.n_evaluations() + gp.n_skipped_evaluations()
+                << " evaluations (" << gp.n_cache_hits() << " cache hits, "
+                << gp.n_rejected_similar() << " similar children rejected)\n";
+      if (gp.n_threads() > 1) {
+        std::cout << "Process " << process_rank << " worker utilisation:";
+        for (const auto utilisation : gp.worker_utilisation()) {
+          std::cout << ' ' << 100 * utilisation << '%';
+        }
+        std::cout << '\n';
+      }
+      if (result["A"].as<bool>()) {
+        std::cout << "Process " << process_rank
+                  << " mutates with probability "
+                  << 0.05 * gp.mutation_probability_factor();
+        // Each worker adapts the operators to the chunks it bred
+        for (size_t w = 0; w < gp.n_threads(); w++) {
+          const auto &operators = gp.ga(w).operator_probabilities();
+          std::cout << ", ";
+          if (gp.n_threads() > 1)
+            std::cout << "worker " << w << ' ';
+          std::cout << "reflection " << operators[0] << " shift "
+                    << operators[1];
+        }
+        std::cout << '\n';
       }
-      std::cout << '\t' << evaluations[i] << '\n';
+      if (process_rank == 0) {
+        if (target_gap > 0)
+          std::cout << "Optimality gap: " << 100 * gp.gap() << "%, ";
+        std::cout << "Finished after " << gp.history().size()
+                  << " blocks and " << gp.n_restarts() << " restarts\n";
+      }
+    };
+    const auto selection = result["S"].as<std::string>();
+    if (selection == "roulette") {
+      solve(genetic::selection::Roulette());
+    } else if (selection == "tournament") {
+      solve(genetic::selection::Tournament(result["k"].as<size_t>()));
+    } else if (selection == "rank") {
+      solve(genetic::selection::LinearRank(result["r"].as<double>()));
+    } else {
+      throw std::runtime_error("Unknown selection policy: " + selection);
     }
 
-    csv::Document solution;
-    for (auto i = 0U; i < std::min(50UL, POPULATION_SIZE); i++) {
-      solution.InsertRow(i, std::vector<unsigned int>(population[i].cbegin(),
-                                                      population[i].cend()));
+    // The padding cities, which end every individual, are dropped
+    const auto n_path = n_cities - 1;
+    if (!new_to_old.empty()) {
+      for (auto &individual : population) {
+        renumbering::restore(individual.begin(),
+                             snext(individual.begin(), n_path), new_to_old);
+      }
+    }
+
+    if (process_rank == 0) {
+      const auto n_best = std::min(50UL, POPULATION_SIZE);
+      std::vector<size_t> best(POPULATION_SIZE);
+      argpartial_sort_n(evaluations.cbegin(), POPULATION_SIZE, n_best,
+                        best.begin(), std::greater<>());
+
+      for (size_t i = 0; i < n_best; i++) {
+        for (size_t j = 0; j < n_path; j++) {
+          std::cout << population[best[i]][j] << ' ';
+        }
+        std::cout << '\t' << evaluations[best[i]] << '\n';
+      }
+
+      csv::Document solution;
+      for (size_t i = 0; i < n_best; i++) {
+        const auto &individual = population[best[i]];
+        solution.InsertRow(i, std::vector<unsigned int>(
+                                  individual.cbegin(),
+                                  snext(individual.cbegin(), n_path)));
+      }
+      solution.Save("p_2fit.csv");
     }
+  };
+  // Larger instances are solved by decomposition on the first process, as
+  // by the solver daemon, without renumbering or warm start
+  if (!buckets::dispatch(buckets::Default(), n_cities, run) &&
+      process_rank == 0) {
+    std::cout << path << " has " << n_cities << " cities, more than "
+              << buckets::largest(buckets::Default())
+              << ": solving by decomposition\n";
+    service::Request request;
+    request.instance = path;
+    // The request seeds the engine of the decomposition from the generator
+    request.seed = rng();
+    request.population_size = POPULATION_SIZE;
+    request.n_iterations = N_ITER * N_BLOCKS;
+    request.mutation_probability = 0.05;
+    const auto response = service::decomposition_engine<metrics::GreatCircle>(
+        std::make_shared<const instance::Instance>(instance))(request);
+    for (const auto c : response.path) {
+      std::cout << c << ' ';
+    }
+    std::cout << '\t' << 1. / response.length << '\n';
+    csv::Document solution;
+    solution.InsertRow(0, std::vector<unsigned int>(response.path.cbegin(),
+                                                    response.path.cend()));
     solution.Save("p_2fit.csv");
   }
+
 #ifdef USE_MPI
   MPI_Finalize();
 #endif
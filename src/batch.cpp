@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cxxopts.hpp>
+#include <rapidcsv.h>
+
+#include "config.hpp"
+#include "genetic_algorithms/metrics.hpp"
+#include "genetic_algorithms/service.hpp"
+
+namespace csv = rapidcsv;
+
+// Runs a list of jobs on a pool of threads. Each instance is loaded once, on
+// the size bucket holding it, and its distance table is shared by all the
+// jobs on it. Jobs draw from their
+// own std::mt19937_64, seeded by the job list, so that results do not
+// depend on the scheduling.
+int main(int argc, char *argv[]) {
+  cxxopts::Options options("Batch", "Run many solves in one process");
+  using cxxopts::value;
+  // clang-format off
+  options.add_options()
+      ("j,jobs", "CSV job list with columns instance, seed, population_size, n_iterations, mutation_probability and selection (roulette, tournament or rank)", value<std::string>())
+      ("o,output", "CSV results file", value<std::string>()->default_value("batch.csv"))
+      ("t,threads", "Worker threads, 0 for one per hardware thread", value<size_t>()->default_value("0"))
+      ("h,help", "Print this message");
+  // clang-format on
+  auto result = options.parse(argc, argv);
+  if (result.count("help") || !result.count("jobs")) {
+    std::cout << options.help() << std::endl;
+    exit(0);
+  }
+
+  const csv::Document jobs(result["j"].as<std::string>());
+  const auto instances = jobs.GetColumn<std::string>("instance");
+  const auto seeds = jobs.GetColumn<unsigned long>("seed");
+  const auto population_sizes = jobs.GetColumn<size_t>("population_size");
+  const auto n_iterations = jobs.GetColumn<size_t>("n_iterations");
+  const auto mutation_probabilities =
+      jobs.GetColumn<double>("mutation_probability");
+  const auto selections = jobs.GetColumn<std::string>("selection");
+  const auto n_jobs = instances.size();
+  std::vector<service::Request> requests(n_jobs);
+  for (size_t j = 0; j < n_jobs; j++) {
+    requests[j] = service::Request{instances[j],        seeds[j],
+                                   population_sizes[j], n_iterations[j],
+                                   mutation_probabilities[j], selections[j]};
+  }
+
+  // Engines are safe to call concurrently
+  std::map<std::string, service::Engine> engines;
+  for (const auto &path : instances) {
+    if (!engines.count(path))
+      engines.try_emplace(
+          path, service::make_engine<metrics::GreatCircle>(path));
+  }
+
+  // Jobs are handed out one at a time, as their costs differ widely
+  std::vector<service::Response> responses(n_jobs);
+  std::atomic<size_t> next_job{0};
+  const auto work = [&]() {
+    for (auto j = next_job++; j < n_jobs; j = next_job++) {
+      try {
+        responses[j] = engines.at(instances[j])(requests[j]);
+      } catch (const std::exception &e) {
+        responses[j].error = e.what();
+      }
+    }
+  };
+  auto n_threads = result["t"].as<size_t>();
+  if (n_threads == 0)
+    n_threads = std::max(size_t(std::thread::hardware_concurrency()), 1UL);
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < n_threads; t++) {
+    workers.emplace_back(work);
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  const std::chrono::duration<double> elapsed = clock::now() - start;
+
+  std::ofstream output(result["o"].as<std::string>());
+  output << "job,instance,seed,length,n_evaluations,seconds,path,error\n";
+  for (size_t j = 0; j < n_jobs; j++) {
+    const auto &response = responses[j];
+    output << j << ',' << instances[j] << ',' << seeds[j] << ','
+           << response.length << ',' << response.n_evaluations << ','
+           << response.seconds << ',';
+    for (const auto c : response.path) {
+      output << c << ' ';
+    }
+    output << ',' << response.error << '\n';
+  }
+  std::cout << n_jobs << " jobs on " << engines.size() << " instances with "
+            << n_threads << " threads in " << elapsed.count() << " s ("
+            << 3600 * double(n_jobs) / elapsed.count() << " jobs/hour)\n";
+  return 0;
+}
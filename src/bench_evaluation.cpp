@@ -0,0 +1,64 @@
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#include "genetic_algorithms/renumbering.hpp"
+#include "genetic_algorithms/tsp_ga.hpp"
+
+#define N_CITIES 1000ULL
+#define POPULATION_SIZE 1000ULL
+#define N_REPETITIONS 20ULL
+
+// Evaluation throughput on a large random instance, with the cities in input
+// order and renumbered along a Hilbert curve. The population is seeded with
+// greedy tours, so that consecutive cities of a tour are close in space.
+int main() {
+  using point = std::valarray<double>;
+  using Problem = TSP<point, N_CITIES, metrics::Euclidean>;
+  using Individual = typename Problem::Individual;
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> coordinate(0, 1);
+  auto coordinates = std::make_unique<std::array<point, N_CITIES>>();
+  std::generate(coordinates->begin(), coordinates->end(),
+                [&]() { return point{coordinate(rng), coordinate(rng)}; });
+
+  const auto new_to_old =
+      renumbering::hilbert(coordinates->cbegin(), N_CITIES);
+  auto renumbered = std::make_unique<std::array<point, N_CITIES>>();
+  renumbering::apply(coordinates->cbegin(), new_to_old, renumbered->begin());
+
+  Problem original_tsp(*coordinates);
+  original_tsp.set_seeding(Problem::Seeding::greedy);
+  std::vector<Individual> population(POPULATION_SIZE);
+  original_tsp.generate(population.begin(), POPULATION_SIZE, rng);
+  std::vector<Individual> renumbered_population(population);
+  for (auto &individual : renumbered_population) {
+    renumbering::renumber(individual.begin(), individual.end(), new_to_old);
+  }
+  Problem renumbered_tsp(*renumbered);
+
+  const auto benchmark = [](Problem &tsp,
+                            const std::vector<Individual> &individuals) {
+    using clock = std::chrono::steady_clock;
+    double checksum = 0;
+    const auto start = clock::now();
+    for (auto r = 0ULL; r < N_REPETITIONS; r++) {
+      for (const auto &individual : individuals) {
+        checksum += tsp.evaluate(individual);
+      }
+    }
+    const std::chrono::duration<double> elapsed = clock::now() - start;
+    std::cout << double(N_REPETITIONS * individuals.size()) / elapsed.count()
+              << " evaluations/s (checksum " << checksum << ")\n";
+  };
+  std::cout << "Input order:      ";
+  benchmark(original_tsp, population);
+  std::cout << "Hilbert order:    ";
+  benchmark(renumbered_tsp, renumbered_population);
+  return 0;
+}
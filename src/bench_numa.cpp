@@ -0,0 +1,124 @@
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "genetic_algorithms/tsp_ga.hpp"
+#include "genetic_process.hpp"
+#include "numa.hpp"
+#include "thread_pool.hpp"
+
+#define N_CITIES 1000ULL
+#define POPULATION_SIZE 1000ULL
+#define N_REPETITIONS 20ULL
+#define N_ITERATIONS 20ULL
+
+namespace numa = genetic::numa;
+using point = std::array<double, 2>;
+using Problem = TSP<point, N_CITIES, metrics::Euclidean>;
+using Individual = typename Problem::Individual;
+
+// Evaluations per second by the workers of one node, each on its own slice
+// of the population, reading a distance table first touched by a thread of
+// the given node
+double throughput(const numa::Topology &topology, size_t worker_node,
+                  size_t table_node, const Problem &prototype,
+                  const std::vector<Individual> &population) {
+  std::optional<Problem> table;
+  std::thread([&]() {
+    numa::pin_current_thread(topology.node_cpus[table_node][0]);
+    table.emplace(prototype.replicate());
+  }).join();
+
+  genetic::ThreadPool pool(topology.node_cpus[worker_node].size(),
+                           topology.restricted_to(worker_node));
+  // The population is local to the workers, only the table may not be
+  auto local = pool.allocate<Individual>(POPULATION_SIZE);
+  std::vector<std::optional<Problem>> copies(pool.size());
+  pool.run([&](const size_t w) {
+    const auto [begin, end] = pool.slice(w, POPULATION_SIZE);
+    std::copy(snext(population.cbegin(), begin),
+              snext(population.cbegin(), end), snext(local.begin(), begin));
+    copies[w].emplace(*table);
+  });
+
+  std::vector<double> checksums(pool.size());
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+  pool.run([&](const size_t w) {
+    const auto [begin, end] = pool.slice(w, POPULATION_SIZE);
+    double checksum = 0;
+    for (auto r = 0ULL; r < N_REPETITIONS; r++) {
+      for (auto i = begin; i < end; i++) {
+        checksum += double(copies[w]->evaluate(local[i]));
+      }
+    }
+    checksums[w] = checksum;
+  });
+  const std::chrono::duration<double> elapsed = clock::now() - start;
+  return double(N_REPETITIONS * POPULATION_SIZE) / elapsed.count();
+}
+
+// Cost of reading a distance table from another socket, and generational
+// runs on one thread and on one worker per CPU, whose GA copies replicate
+// the table on each node. Without several NUMA nodes only the local
+// throughput can be measured.
+int main() {
+  const auto topology = numa::Topology::detect();
+  std::cout << topology.n_nodes() << " NUMA nodes:";
+  size_t n_cpus = 0;
+  for (const auto &cpus : topology.node_cpus) {
+    std::cout << ' ' << cpus.size();
+    n_cpus += cpus.size();
+  }
+  std::cout << " CPUs\n";
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> coordinate(0, 1);
+  auto coordinates = std::make_unique<std::array<point, N_CITIES>>();
+  std::generate(coordinates->begin(), coordinates->end(),
+                [&]() { return point{coordinate(rng), coordinate(rng)}; });
+  Problem prototype(*coordinates);
+  std::vector<Individual> population(POPULATION_SIZE);
+  prototype.generate(population.begin(), POPULATION_SIZE, rng);
+
+  std::cout << "Evaluations/s of the workers of a node by node of the "
+               "distance table\n";
+  for (size_t worker_node = 0; worker_node < topology.n_nodes();
+       worker_node++) {
+    for (size_t table_node = 0; table_node < topology.n_nodes();
+         table_node++) {
+      std::cout << "  workers on " << worker_node << ", table on "
+                << table_node << (worker_node == table_node ? " (local):  "
+                                                            : " (remote): ")
+                << throughput(topology, worker_node, table_node, prototype,
+                              population)
+                << '\n';
+    }
+  }
+
+  std::vector<size_t> thread_counts{1};
+  if (n_cpus > 1)
+    thread_counts.push_back(n_cpus);
+  for (const auto n_threads : thread_counts) {
+    genetic::Process gp(Problem(prototype), genetic::selection::Tournament(3));
+    gp.set_threads(n_threads);
+    auto individuals = gp.allocate<Individual>(POPULATION_SIZE);
+    auto evaluations =
+        gp.allocate<typename Problem::FitnessMeasure>(POPULATION_SIZE);
+    std::mt19937_64 run_rng(1);
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    gp.run(individuals.begin(), POPULATION_SIZE, evaluations.begin(),
+           N_ITERATIONS, 0.05, run_rng);
+    const std::chrono::duration<double> elapsed = clock::now() - start;
+    std::cout << "Run on " << n_threads << " threads: "
+              << double(N_ITERATIONS) / elapsed.count()
+              << " generations/s\n";
+  }
+  return 0;
+}
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+#include "ariel_random.hpp"
+#include "config.hpp"
+#include "genetic_algorithms/decomposition.hpp"
+#include "genetic_algorithms/metrics.hpp"
+
+#define CLUSTER_SIZE 100UL
+
+// Random instance in the unit square, far larger than a single TSP can hold,
+// solved by decomposition. The clusters are shared among the MPI processes.
+int main(int argc, char *argv[]) {
+  cxxopts::Options options("Decomposition",
+                           "Solve a large random instance by decomposition");
+  using cxxopts::value;
+  // clang-format off
+  options.add_options()
+      ("N,n_cities", "Number of cities", value<size_t>()->default_value("20000"))
+      ("m,n_iterations", "Number of iterations per cluster", value<size_t>()->default_value("200"))
+      ("p,population_size", "Population size per cluster", value<size_t>()->default_value("100"))
+      ("w,window", "Positions around each joint improved by 2-opt", value<size_t>()->default_value("20"))
+      ("h,help", "Print this message");
+  // clang-format on
+  auto result = options.parse(argc, argv);
+  if (result.count("help")) {
+    std::cout << options.help() << std::endl;
+    exit(0);
+  }
+  const auto N = result["N"].as<size_t>();
+
+  int process_rank = 0;
+  int n_procs = 1;
+#ifdef USE_MPI
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &process_rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &n_procs);
+#endif
+
+  using point = std::valarray<double>;
+  using Metric = metrics::Euclidean;
+  // Every process builds the same instance
+  std::mt19937 instance_rng(42);
+  std::uniform_real_distribution<double> coordinate(0, 1);
+  std::vector<point> coordinates(N);
+  std::generate(coordinates.begin(), coordinates.end(), [&]() {
+    return point{coordinate(instance_rng), coordinate(instance_rng)};
+  });
+  const auto distance = [&](const size_t x, const size_t y) {
+    return Metric::distance(coordinates[x], coordinates[y]);
+  };
+  const auto length = [&](const std::vector<size_t> &path) {
+    double total = 0;
+    for (size_t i = 1; i < path.size(); i++) {
+      total += distance(path[i - 1], path[i]);
+    }
+    return total;
+  };
+
+  using Rng = ARandom;
+  Rng rng(SEEDS_PATH "seed.in", PRIMES_PATH "primes32001.in",
+          size_t(process_rank));
+
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+  const auto clusters =
+      decomposition::partition(coordinates.cbegin(), N, CLUSTER_SIZE);
+  // Cluster k is solved by process k % n_procs, and its path is written at
+  // the position of its first city in the stitched path
+  std::vector<unsigned> local_paths(N, 0), paths(N, 0);
+  for (auto k = size_t(process_rank); k < clusters.size();
+       k += size_t(n_procs)) {
+    const auto path = decomposition::solve_cluster<CLUSTER_SIZE, Metric>(
+        coordinates.cbegin(), clusters[k], result["p"].as<size_t>(),
+        result["m"].as<size_t>(), 0.05, rng);
+    std::transform(path.cbegin(), path.cend(),
+                   snext(local_paths.begin(), k * CLUSTER_SIZE),
+                   [](const auto c) { return unsigned(c); });
+  }
+#ifdef USE_MPI
+  // Each position is written by one process only
+  MPI_Reduce(local_paths.data(), paths.data(), int(N), MPI_UNSIGNED, MPI_SUM,
+             0, MPI_COMM_WORLD);
+#else
+  paths = local_paths;
+#endif
+
+  if (process_rank == 0) {
+    std::vector<std::vector<size_t>> sub_paths(clusters.size());
+    std::vector<size_t> joints;
+    for (size_t k = 0; k < clusters.size(); k++) {
+      const auto first = snext(paths.cbegin(), k * CLUSTER_SIZE);
+      sub_paths[k].assign(first, snext(first, clusters[k].size()));
+      if (k > 0)
+        joints.push_back(k * CLUSTER_SIZE);
+    }
+    auto path = decomposition::stitch(sub_paths, distance);
+    const auto stitched_length = length(path);
+    const auto n_moves = decomposition::repair(
+        path, joints, result["w"].as<size_t>(), distance);
+    const std::chrono::duration<double> elapsed = clock::now() - start;
+
+    std::cout << clusters.size() << " clusters of " << CLUSTER_SIZE
+              << " cities over " << n_procs << " processes\n"
+              << "Stitched path length: " << stitched_length << '\n'
+              << "Repaired path length: " << length(path) << " (" << n_moves
+              << " 2-opt moves)\n"
+              << "Elapsed: " << elapsed.count() << " s\n";
+  }
+#ifdef USE_MPI
+  MPI_Finalize();
+#endif
+  return 0;
+}
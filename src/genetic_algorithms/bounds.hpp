@@ -0,0 +1,96 @@
+#ifndef GENETIC_TSP_BOUNDS_HPP
+#define GENETIC_TSP_BOUNDS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+// Lower bounds on the length of the shortest path through N cities starting
+// from city 0, which is the quantity TSP minimises.
+namespace bounds {
+
+// Held-Karp bound: the path closed by a dummy city, joined to city 0 and to
+// its last city at no cost, is a tour. So it is a 1-tree in which the dummy
+// city is the special node with an edge to city 0, and its length is at
+// least the one of the minimum such 1-tree. Penalties on the cities, moved
+// by subgradient steps towards an upper bound, push the 1-tree towards a
+// tour and raise the bound.
+template <typename DistanceFn>
+double held_karp(size_t N, DistanceFn &&distance, double upper_bound,
+                 size_t n_iterations) {
+  if (N < 2)
+    return 0;
+  constexpr auto infinity = std::numeric_limits<double>::max();
+  std::vector<double> penalty(N, 0.), key(N);
+  std::vector<size_t> parent(N);
+  std::vector<bool> in_tree(N);
+  std::vector<int> degree(N);
+  double best = 0;
+  double step_scale = 2;
+  // The step is halved after this many iterations without improvement
+  const auto patience = std::max(N / 4, size_t(10));
+  size_t since_improvement = 0;
+  for (size_t iteration = 0; iteration < n_iterations; iteration++) {
+    // Prim's algorithm on the penalised distances, O(N^2) on a dense graph
+    std::fill(key.begin(), key.end(), infinity);
+    std::fill(in_tree.begin(), in_tree.end(), false);
+    std::fill(degree.begin(), degree.end(), 0);
+    key[0] = 0;
+    parent[0] = N;
+    double tree = 0;
+    for (size_t k = 0; k < N; k++) {
+      size_t u = N;
+      for (size_t v = 0; v < N; v++) {
+        if (!in_tree[v] && (u == N || key[v] < key[u]))
+          u = v;
+      }
+      in_tree[u] = true;
+      tree += key[u];
+      if (parent[u] != N) {
+        degree[u]++;
+        degree[parent[u]]++;
+      }
+      for (size_t v = 0; v < N; v++) {
+        const auto d = double(distance(u, v)) + penalty[u] + penalty[v];
+        if (!in_tree[v] && d < key[v]) {
+          key[v] = d;
+          parent[v] = u;
+        }
+      }
+    }
+    // The dummy city joins city 0 and the cheapest other city
+    const auto other = size_t(std::distance(
+        penalty.cbegin(),
+        std::min_element(std::next(penalty.cbegin()), penalty.cend())));
+    tree += penalty[0] + penalty[other];
+    degree[0]++;
+    degree[other]++;
+
+    const auto bound =
+        tree - 2 * std::accumulate(penalty.cbegin(), penalty.cend(), 0.);
+    if (bound > best) {
+      best = bound;
+      since_improvement = 0;
+    } else if (++since_improvement == patience) {
+      step_scale /= 2;
+      since_improvement = 0;
+    }
+    double norm = 0;
+    for (const auto d : degree) {
+      norm += double((d - 2) * (d - 2));
+    }
+    // A 1-tree in which every city has degree 2 is an optimal tour
+    if (norm == 0. || upper_bound <= bound)
+      break;
+    const auto step = step_scale * (upper_bound - bound) / norm;
+    for (size_t i = 0; i < N; i++) {
+      penalty[i] += step * double(degree[i] - 2);
+    }
+  }
+  return best;
+}
+} // namespace bounds
+
+#endif // GENETIC_TSP_BOUNDS_HPP
@@ -0,0 +1,36 @@
+#ifndef GENETIC_TSP_BUCKETS_HPP
+#define GENETIC_TSP_BUCKETS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+// Instance sizes chosen at run time for code instantiated at compile time.
+// A TSP is instantiated once per bucket, and an instance runs on the smallest
+// bucket holding it, padded as by the TSP constructor from a std::vector, so
+// that it keeps the fixed trip counts and stack-resident individuals of a TSP
+// built for its exact size.
+namespace buckets {
+
+// Increasing bucket sizes
+template <size_t... SIZES> struct Sizes {};
+
+// TSP is limited to 1000 cities
+using Default = Sizes<64, 128, 256, 512, 1000>;
+
+// Calls f(std::integral_constant<size_t, SIZE>{}) for the smallest SIZE
+// holding n cities. Returns false, without calling f, if none does.
+template <size_t... SIZES, class F>
+bool dispatch(Sizes<SIZES...>, const size_t n, F &&f) {
+  static_assert(sizeof...(SIZES) > 0);
+  return ((n <= SIZES ? (f(std::integral_constant<size_t, SIZES>{}), true)
+                      : false) ||
+          ...);
+}
+
+template <size_t... SIZES> constexpr size_t largest(Sizes<SIZES...>) {
+  return std::max({SIZES...});
+}
+} // namespace buckets
+
+#endif // GENETIC_TSP_BUCKETS_HPP
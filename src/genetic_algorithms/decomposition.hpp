@@ -0,0 +1,152 @@
+#ifndef GENETIC_TSP_DECOMPOSITION_HPP
+#define GENETIC_TSP_DECOMPOSITION_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include "genetic_process.hpp"
+#include "renumbering.hpp"
+#include "tsp_ga.hpp"
+
+// Solver for instances too large for a single population: the cities are
+// split into spatially compact clusters of a fixed size, each cluster is
+// solved by its own genetic::Process, and the sub-paths are stitched into a
+// path through every city, whose joints are finally improved by 2-opt.
+namespace decomposition {
+
+// Consecutive runs of cluster_size cities along the Hilbert curve, the last
+// one possibly shorter. City 0 opens the first cluster, so that the stitched
+// path starts from it.
+template <typename CoordinatesIt>
+std::vector<std::vector<size_t>> partition(CoordinatesIt first, size_t N,
+                                           size_t cluster_size) {
+  const auto order = renumbering::hilbert(first, N);
+  std::vector<std::vector<size_t>> clusters;
+  for (size_t begin = 0; begin < N; begin += cluster_size) {
+    const auto end = std::min(begin + cluster_size, N);
+    clusters.emplace_back(snext(order.cbegin(), begin),
+                          snext(order.cbegin(), end));
+  }
+  return clusters;
+}
+
+// Best path through a cluster, starting from its first city. Clusters
+// smaller than CLUSTER_SIZE run on a padded TSP. Steady state with
+// tournaments keeps the greedy seed from being lost, and a 2-opt local
+// search follows each mutation.
+template <size_t CLUSTER_SIZE, class Metric, typename CoordinatesIt,
+          class RNG>
+std::vector<size_t> solve_cluster(CoordinatesIt first,
+                                  const std::vector<size_t> &cluster,
+                                  size_t population_size, size_t n_iterations,
+                                  double mutation_probability, RNG &rng) {
+  using Coordinates = typename std::iterator_traits<CoordinatesIt>::value_type;
+  using Problem = TSP<Coordinates, CLUSTER_SIZE, Metric>;
+  if (cluster.size() < 2)
+    return cluster;
+  std::vector<Coordinates> coordinates(cluster.size());
+  for (size_t i = 0; i < cluster.size(); i++) {
+    coordinates[i] = *snext(first, cluster[i]);
+  }
+  Problem tsp(coordinates, std::vector<double>());
+  tsp.set_seeding(Problem::Seeding::greedy);
+  tsp.set_local_search(10 * CLUSTER_SIZE);
+  genetic::Process gp(std::move(tsp), genetic::selection::Tournament(3));
+  gp.set_steady_state(true);
+  std::vector<typename Problem::Individual> population(population_size);
+  std::vector<typename Problem::FitnessMeasure> evaluations(population_size);
+  gp.run(population.begin(), population_size, evaluations.begin(),
+         n_iterations, mutation_probability, rng);
+
+  const auto best =
+      std::max_element(evaluations.cbegin(), evaluations.cend());
+  std::vector<size_t> path{cluster[0]};
+  for (const auto c : population[size_t(best - evaluations.cbegin())]) {
+    if (c < cluster.size())
+      path.push_back(cluster[c]);
+  }
+  return path;
+}
+
+// Joins the sub-paths in cluster order, reversing each one if its last city
+// is closer than its first to the end of the path built so far
+template <typename DistanceFn>
+std::vector<size_t> stitch(const std::vector<std::vector<size_t>> &paths,
+                           DistanceFn &&distance) {
+  std::vector<size_t> path;
+  for (const auto &sub_path : paths) {
+    if (!path.empty() && double(distance(path.back(), sub_path.back())) <
+                             double(distance(path.back(), sub_path.front())))
+      path.insert(path.end(), sub_path.crbegin(), sub_path.crend());
+    else
+      path.insert(path.end(), sub_path.cbegin(), sub_path.cend());
+  }
+  return path;
+}
+
+// 2-opt restricted to the window positions around each joint, repeated until
+// no move improves the path. The first city is kept in place and the path is
+// open, so reversing a suffix only changes its first edge. Returns the
+// number of moves applied.
+template <typename DistanceFn>
+size_t repair(std::vector<size_t> &path, const std::vector<size_t> &joints,
+              size_t window, DistanceFn &&distance) {
+  const auto N = path.size();
+  const auto cost = [&](const size_t i, const size_t j) {
+    return j < N ? double(distance(path[i], path[j])) : 0.;
+  };
+  size_t n_moves = 0;
+  for (bool improved = true; improved;) {
+    improved = false;
+    for (const auto joint : joints) {
+      const auto low = joint > window ? joint - window : 0;
+      const auto high = std::min(joint + window, N - 1);
+      // Reversing path[i + 1..j] replaces the edges (i, i + 1), (j, j + 1)
+      for (auto i = low; i < high; i++) {
+        for (auto j = i + 2; j <= high; j++) {
+          const auto gain =
+              cost(i, i + 1) + cost(j, j + 1) - cost(i, j) - cost(i + 1, j + 1);
+          if (gain > 1e-12) {
+            std::reverse(snext(path.begin(), i + 1),
+                         snext(path.begin(), j + 1));
+            improved = true;
+            n_moves++;
+          }
+        }
+      }
+    }
+  }
+  return n_moves;
+}
+
+// Path through the N cities, solving their clusters one after the other
+// and repairing the joints within window positions
+template <size_t CLUSTER_SIZE, class Metric, typename CoordinatesIt,
+          class RNG>
+std::vector<size_t> solve(CoordinatesIt first, size_t N,
+                          size_t population_size, size_t n_iterations,
+                          double mutation_probability, size_t window,
+                          RNG &rng) {
+  const auto clusters = partition(first, N, CLUSTER_SIZE);
+  std::vector<std::vector<size_t>> paths;
+  std::vector<size_t> joints;
+  for (size_t k = 0; k < clusters.size(); k++) {
+    paths.push_back(solve_cluster<CLUSTER_SIZE, Metric>(
+        first, clusters[k], population_size, n_iterations,
+        mutation_probability, rng));
+    if (k > 0)
+      joints.push_back(k * CLUSTER_SIZE);
+  }
+  const auto distance = [&](const size_t x, const size_t y) {
+    return Metric::distance(*snext(first, x), *snext(first, y));
+  };
+  auto path = stitch(paths, distance);
+  repair(path, joints, window, distance);
+  return path;
+}
+} // namespace decomposition
+
+#endif // GENETIC_TSP_DECOMPOSITION_HPP
@@ -0,0 +1,97 @@
+#ifndef GENETIC_TSP_EDGE_FREQUENCY_HPP
+#define GENETIC_TSP_EDGE_FREQUENCY_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "utils.hpp"
+
+// How many paths of a population use each undirected edge. Adding or
+// removing a path costs O(N), after which the diversity of the population
+// and the similarity of a path to it are available without comparing paths
+// pairwise. Paths start from city 0, which they do not list. Only the first
+// n_cities - 1 cities of a path are counted, so that the padding cities of a
+// bucket larger than the instance, which never move, do not count as shared.
+template <size_t N_CITIES> class EdgeFrequency {
+public:
+  explicit EdgeFrequency(const size_t n_cities = N_CITIES)
+      : m_n_cities(n_cities), m_count(n_cities * n_cities, 0) {}
+
+  template <typename PopulationIt> void assign(PopulationIt first, size_t N) {
+    clear();
+    for (size_t i = 0; i < N; i++) {
+      add(*snext(first, i));
+    }
+  }
+
+  void clear() {
+    std::fill(m_count.begin(), m_count.end(), 0);
+    m_size = 0;
+    m_f_log_f = 0;
+  }
+
+  template <typename Path> void add(const Path &path) {
+    for_each_edge(path, [&](const size_t e) {
+      m_f_log_f += f_log_f(m_count[e] + 1) - f_log_f(m_count[e]);
+      m_count[e]++;
+    });
+    m_size++;
+  }
+
+  template <typename Path> void remove(const Path &path) {
+    for_each_edge(path, [&](const size_t e) {
+      m_f_log_f += f_log_f(m_count[e] - 1) - f_log_f(m_count[e]);
+      m_count[e]--;
+    });
+    m_size--;
+  }
+
+  [[nodiscard]] size_t size() const { return m_size; }
+
+  // Mean fraction of the paths sharing each edge of the given one, which is
+  // the expected fraction of its edges shared with a random path
+  template <typename Path>
+  [[nodiscard]] double similarity(const Path &path) const {
+    if (m_size == 0)
+      return 0;
+    double shared = 0;
+    for_each_edge(path, [&](const size_t e) { shared += m_count[e]; });
+    return shared / double(m_size * (m_n_cities - 1));
+  }
+
+  // Entropy of the edge frequencies, scaled to 0 when every path is the
+  // same and to 1 when no two paths share an edge
+  [[nodiscard]] double diversity() const {
+    if (m_size < 2)
+      return 0;
+    const auto total = double(m_size * (m_n_cities - 1));
+    const auto entropy = std::log(total) - m_f_log_f / total;
+    return (entropy - std::log(double(m_n_cities - 1))) /
+           std::log(double(m_size));
+  }
+
+private:
+  size_t m_n_cities;
+  std::vector<unsigned> m_count;
+  size_t m_size{0};
+  // Sum of f log f over the edge counts f
+  double m_f_log_f{0};
+
+  [[nodiscard]] static inline double f_log_f(const unsigned f) {
+    return f > 0 ? double(f) * std::log(double(f)) : 0.;
+  }
+
+  template <typename Path, typename F>
+  inline void for_each_edge(const Path &path, F &&f) const {
+    size_t from = 0;
+    for (size_t i = 0; i + 1 < m_n_cities; i++) {
+      const size_t to = path[i];
+      f(std::min(from, to) * m_n_cities + std::max(from, to));
+      from = to;
+    }
+  }
+};
+
+#endif // GENETIC_TSP_EDGE_FREQUENCY_HPP
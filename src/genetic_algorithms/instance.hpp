@@ -0,0 +1,328 @@
+#ifndef GENETIC_TSP_INSTANCE_HPP
+#define GENETIC_TSP_INSTANCE_HPP
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "metrics.hpp"
+
+// Loader of TSPLIB .tsp files and of CSV files with a header. Files are
+// memory mapped and parsed in place with std::from_chars, so that the only
+// allocations are the coordinate and distance storage themselves.
+namespace instance {
+
+// Read-only mapping of a whole file
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &path) {
+    const auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("Cannot open " + path);
+    struct stat status {};
+    if (::fstat(fd, &status) != 0) {
+      ::close(fd);
+      throw std::runtime_error("Cannot stat " + path);
+    }
+    m_size = size_t(status.st_size);
+    if (m_size > 0) {
+      m_data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (m_data == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("Cannot map " + path);
+      }
+    }
+    ::close(fd);
+  }
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile() {
+    if (m_size > 0)
+      ::munmap(m_data, m_size);
+  }
+
+  [[nodiscard]] std::string_view view() const {
+    return {static_cast<const char *>(m_data), m_size};
+  }
+
+private:
+  void *m_data{nullptr};
+  size_t m_size{0};
+};
+
+struct Instance {
+  std::string name;
+  // TSPLIB EDGE_WEIGHT_TYPE, empty for CSV files
+  std::string edge_weight_type;
+  // Two coordinates per city, zero when the file only gives weights
+  std::vector<std::array<double, 2>> coordinates;
+  // Full N x N matrix of an EXPLICIT instance, empty otherwise
+  std::vector<double> weights;
+
+  [[nodiscard]] size_t size() const { return coordinates.size(); }
+
+  // Full N x N distance matrix under the TSPLIB edge weight type
+  [[nodiscard]] std::vector<double> distances() const {
+    if (!weights.empty())
+      return weights;
+    if (edge_weight_type == "EUC_2D")
+      return matrix<metrics::RoundedEuclidean>();
+    if (edge_weight_type == "ATT")
+      return matrix<metrics::ATT>();
+    if (edge_weight_type == "GEO")
+      return matrix<metrics::Geo>();
+    throw std::runtime_error("Unsupported edge weight type: " +
+                             edge_weight_type);
+  }
+
+private:
+  template <class Metric> [[nodiscard]] std::vector<double> matrix() const {
+    const auto N = size();
+    std::vector<double> d(N * N, 0.);
+    for (size_t x = 0; x < N; x++) {
+      for (size_t y = 0; y < x; y++) {
+        d[x * N + y] = d[y * N + x] =
+            Metric::distance(coordinates[x], coordinates[y]);
+      }
+    }
+    return d;
+  }
+};
+
+namespace detail {
+// Cursor over the mapped text
+class Scanner {
+public:
+  explicit Scanner(std::string_view text) : m_text(text) {}
+
+  [[nodiscard]] bool done() {
+    skip_space();
+    return m_position == m_text.size();
+  }
+
+  // Next run of characters that are not blanks or any of the delimiters
+  std::string_view token(std::string_view delimiters = "") {
+    skip_space();
+    const auto first = m_position;
+    while (m_position < m_text.size() && !is_space(m_text[m_position]) &&
+           delimiters.find(m_text[m_position]) == std::string_view::npos)
+      m_position++;
+    return m_text.substr(first, m_position - first);
+  }
+
+  template <typename T> T number() {
+    skip_space();
+    T value{};
+    const auto first = m_text.data() + m_position;
+    const auto last = m_text.data() + m_text.size();
+    const auto [end, error] = std::from_chars(first, last, value);
+    if (error != std::errc())
+      throw std::runtime_error("Expected a number near \"" +
+                               std::string(m_text.substr(m_position, 20)) +
+                               "\"");
+    m_position += size_t(end - first);
+    return value;
+  }
+
+  // Text up to the next comma or end of line
+  std::string_view field() {
+    skip_space(false);
+    const auto first = m_position;
+    while (m_position < m_text.size() && m_text[m_position] != ',' &&
+           m_text[m_position] != '\n')
+      m_position++;
+    return m_text.substr(first, m_position - first);
+  }
+
+  // Consumes the character if it comes next, blanks aside
+  bool accept(char c) {
+    skip_space();
+    if (m_position < m_text.size() && m_text[m_position] == c) {
+      m_position++;
+      return true;
+    }
+    return false;
+  }
+
+  // Rest of the current line, without surrounding blanks
+  std::string_view line() {
+    skip_space(false);
+    const auto first = m_position;
+    while (m_position < m_text.size() && m_text[m_position] != '\n')
+      m_position++;
+    auto value = m_text.substr(first, m_position - first);
+    while (!value.empty() && is_space(value.back()))
+      value.remove_suffix(1);
+    return value;
+  }
+
+private:
+  std::string_view m_text;
+  size_t m_position{0};
+
+  static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  }
+  void skip_space(bool newlines = true) {
+    while (m_position < m_text.size() && is_space(m_text[m_position]) &&
+           (newlines || m_text[m_position] != '\n'))
+      m_position++;
+  }
+};
+
+// Fills the full matrix from the EDGE_WEIGHT_FORMAT layout
+inline void read_weights(Scanner &scanner, std::string_view format, size_t N,
+                         std::vector<double> &weights) {
+  weights.assign(N * N, 0.);
+  const auto set = [&](size_t x, size_t y) {
+    weights[x * N + y] = weights[y * N + x] = scanner.number<double>();
+  };
+  if (format == "FULL_MATRIX") {
+    for (size_t x = 0; x < N; x++) {
+      for (size_t y = 0; y < N; y++) {
+        weights[x * N + y] = scanner.number<double>();
+      }
+    }
+  } else if (format == "UPPER_ROW" || format == "UPPER_DIAG_ROW") {
+    const size_t diagonal = format == "UPPER_ROW" ? 1 : 0;
+    for (size_t x = 0; x < N; x++) {
+      for (size_t y = x + diagonal; y < N; y++) {
+        set(x, y);
+      }
+    }
+  } else if (format == "LOWER_ROW" || format == "LOWER_DIAG_ROW") {
+    const size_t diagonal = format == "LOWER_ROW" ? 0 : 1;
+    for (size_t x = 0; x < N; x++) {
+      for (size_t y = 0; y < x + diagonal; y++) {
+        set(x, y);
+      }
+    }
+  } else {
+    throw std::runtime_error("Unsupported edge weight format: " +
+                             std::string(format));
+  }
+}
+
+inline void read_coordinates(Scanner &scanner, size_t N,
+                             std::vector<std::array<double, 2>> &coordinates) {
+  coordinates.assign(N, {0., 0.});
+  for (size_t i = 0; i < N; i++) {
+    const auto id = scanner.number<size_t>();
+    if (id < 1 || id > N)
+      throw std::runtime_error("Node " + std::to_string(id) +
+                               " out of range");
+    coordinates[id - 1][0] = scanner.number<double>();
+    coordinates[id - 1][1] = scanner.number<double>();
+  }
+}
+} // namespace detail
+
+inline Instance load_tsplib(const std::string &path) {
+  const MappedFile file(path);
+  detail::Scanner scanner(file.view());
+  Instance instance;
+  size_t N = 0;
+  std::string_view weight_format;
+  while (!scanner.done()) {
+    const auto keyword = scanner.token(":");
+    if (keyword == "EOF")
+      break;
+    if (keyword == "NODE_COORD_SECTION" || keyword == "DISPLAY_DATA_SECTION") {
+      detail::read_coordinates(scanner, N, instance.coordinates);
+    } else if (keyword == "EDGE_WEIGHT_SECTION") {
+      detail::read_weights(scanner, weight_format, N, instance.weights);
+    } else if (scanner.accept(':')) {
+      if (keyword == "DIMENSION") {
+        N = scanner.number<size_t>();
+      } else {
+        const auto value = scanner.line();
+        if (keyword == "NAME")
+          instance.name = value;
+        else if (keyword == "EDGE_WEIGHT_TYPE")
+          instance.edge_weight_type = value;
+        else if (keyword == "EDGE_WEIGHT_FORMAT")
+          weight_format = value;
+        else if (keyword == "TYPE" && value != "TSP")
+          throw std::runtime_error("Unsupported problem type: " +
+                                   std::string(value));
+      }
+    } else {
+      throw std::runtime_error("Unsupported section: " +
+                               std::string(keyword));
+    }
+  }
+  if (instance.coordinates.empty())
+    instance.coordinates.assign(N, {0., 0.});
+  return instance;
+}
+
+// Comma-separated values with a header, reading the coordinates from the
+// two named columns
+inline Instance load_csv(const std::string &path, std::string_view x_column,
+                         std::string_view y_column) {
+  const MappedFile file(path);
+  detail::Scanner scanner(file.view());
+  Instance instance;
+  instance.name = path;
+
+  const auto header = scanner.line();
+  constexpr auto none = std::string_view::npos;
+  size_t n_columns = 0, x_index = none, y_index = none;
+  for (size_t first = 0; first <= header.size(); n_columns++) {
+    auto last = header.find(',', first);
+    if (last == none)
+      last = header.size();
+    const auto column = header.substr(first, last - first);
+    if (column == x_column)
+      x_index = n_columns;
+    if (column == y_column)
+      y_index = n_columns;
+    first = last + 1;
+  }
+  if (x_index == none || y_index == none)
+    throw std::runtime_error("Missing coordinate columns in " + path);
+  const auto view = file.view();
+  instance.coordinates.reserve(
+      size_t(std::count(view.cbegin(), view.cend(), '\n')));
+
+  while (!scanner.done()) {
+    std::array<double, 2> point{};
+    for (size_t column = 0; column < n_columns; column++) {
+      if (column == x_index)
+        point[0] = scanner.number<double>();
+      else if (column == y_index)
+        point[1] = scanner.number<double>();
+      else
+        scanner.field();
+      if (column + 1 < n_columns && !scanner.accept(','))
+        throw std::runtime_error("Expected " + std::to_string(n_columns) +
+                                 " columns in " + path);
+    }
+    instance.coordinates.push_back(point);
+  }
+  return instance;
+}
+
+// TSPLIB when the path ends in .tsp, CSV with longitude and latitude columns
+// otherwise
+inline Instance load(const std::string &path) {
+  const std::string_view extension = ".tsp";
+  if (path.size() >= extension.size() &&
+      path.compare(path.size() - extension.size(), extension.size(),
+                   extension) == 0)
+    return load_tsplib(path);
+  return load_csv(path, "longitude", "latitude");
+}
+} // namespace instance
+
+#endif // GENETIC_TSP_INSTANCE_HPP
@@ -0,0 +1,98 @@
+#ifndef GENETIC_TSP_METRICS_HPP
+#define GENETIC_TSP_METRICS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// Distance policies for TSP. Each policy exposes a static `distance` kernel
+// over two coordinate vectors, so that the metric is resolved at compile time
+// and inlined in the distance table construction.
+namespace metrics {
+
+struct L1 {
+  template <typename Coordinates>
+  [[nodiscard]] static inline double distance(const Coordinates &x,
+                                              const Coordinates &y) {
+    double d = 0;
+    for (size_t i = 0; i < std::size(x); i++) {
+      d += std::abs(double(x[i]) - double(y[i]));
+    }
+    return d;
+  }
+};
+
+struct Euclidean {
+  template <typename Coordinates>
+  [[nodiscard]] static inline double distance(const Coordinates &x,
+                                              const Coordinates &y) {
+    double d2 = 0;
+    for (size_t i = 0; i < std::size(x); i++) {
+      const auto d = double(x[i]) - double(y[i]);
+      d2 += d * d;
+    }
+    return std::sqrt(d2);
+  }
+};
+
+// TSPLIB EUC_2D: euclidean distance rounded to the nearest integer, halves
+// up as the nint of TSPLIB, whatever the rounding mode
+struct RoundedEuclidean {
+  template <typename Coordinates>
+  [[nodiscard]] static inline double distance(const Coordinates &x,
+                                              const Coordinates &y) {
+    return std::floor(Euclidean::distance(x, y) + 0.5);
+  }
+};
+
+// TSPLIB ATT: pseudo-euclidean distance, rounded up
+struct ATT {
+  template <typename Coordinates>
+  [[nodiscard]] static inline double distance(const Coordinates &x,
+                                              const Coordinates &y) {
+    const auto r = Euclidean::distance(x, y) / std::sqrt(10.);
+    const auto t = std::floor(r + 0.5);
+    return t < r ? t + 1 : t;
+  }
+};
+
+// Great-circle distance in km between (longitude, latitude) pairs expressed
+// in decimal degrees, which is the layout of the American capitals points.
+struct GreatCircle {
+  static constexpr double earth_radius = 6378.388;
+
+  template <typename Coordinates>
+  [[nodiscard]] static inline double distance(const Coordinates &x,
+                                              const Coordinates &y) {
+    constexpr double to_rad = M_PI / 180.;
+    const auto lat_x = double(x[1]) * to_rad;
+    const auto lat_y = double(y[1]) * to_rad;
+    const auto s_lat = std::sin((lat_y - lat_x) / 2);
+    const auto s_lon = std::sin((double(y[0]) - double(x[0])) * to_rad / 2);
+    const auto h =
+        s_lat * s_lat + std::cos(lat_x) * std::cos(lat_y) * s_lon * s_lon;
+    return 2 * earth_radius * std::asin(std::sqrt(std::min(h, 1.)));
+  }
+};
+// TSPLIB GEO: (latitude, longitude) pairs in DDD.MM degrees and minutes,
+// with the TSPLIB rounding of the great-circle distance in km
+struct Geo {
+  template <typename Coordinates>
+  [[nodiscard]] static inline double distance(const Coordinates &x,
+                                              const Coordinates &y) {
+    const auto radians = [](const double value) {
+      const auto degrees = std::trunc(value);
+      return 3.141592 * (degrees + 5. * (value - degrees) / 3.) / 180.;
+    };
+    const auto lat_x = radians(double(x[0])), lon_x = radians(double(x[1]));
+    const auto lat_y = radians(double(y[0])), lon_y = radians(double(y[1]));
+    const auto q1 = std::cos(lon_x - lon_y);
+    const auto q2 = std::cos(lat_x - lat_y);
+    const auto q3 = std::cos(lat_x + lat_y);
+    return std::trunc(
+        6378.388 * std::acos(0.5 * ((1. + q1) * q2 - (1. - q1) * q3)) + 1.);
+  }
+};
+} // namespace metrics
+
+#endif // GENETIC_TSP_METRICS_HPP
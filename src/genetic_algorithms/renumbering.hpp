@@ -0,0 +1,59 @@
+#ifndef GENETIC_TSP_RENUMBERING_HPP
+#define GENETIC_TSP_RENUMBERING_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include "seeding.hpp"
+
+// City renumberings that make cities close in space close in memory, so that
+// good tours read the coordinates and the distance table almost sequentially.
+// A renumbering is stored as new_to_old: new_to_old[i] is the original id of
+// city i.
+namespace renumbering {
+
+// Ids along the Hilbert curve. City 0 keeps its id, since paths start from it.
+template <typename CoordinatesIt>
+std::vector<size_t> hilbert(CoordinatesIt first, size_t N) {
+  auto new_to_old = seeding::hilbert_order(first, N);
+  std::rotate(new_to_old.begin(),
+              std::find(new_to_old.begin(), new_to_old.end(), size_t(0)),
+              new_to_old.end());
+  return new_to_old;
+}
+
+// Writes the elements of an array indexed by original id in the new order
+template <typename InputIt, typename OutputIt>
+void apply(InputIt first, const std::vector<size_t> &new_to_old,
+           OutputIt first_out) {
+  std::transform(new_to_old.cbegin(), new_to_old.cend(), first_out,
+                 [&](const auto old) {
+                   return *std::next(first, std::ptrdiff_t(old));
+                 });
+}
+
+// Maps a sequence of renumbered city ids back to the original ones
+template <typename CityIt>
+void restore(CityIt first, CityIt last, const std::vector<size_t> &new_to_old) {
+  using city_t = typename std::iterator_traits<CityIt>::value_type;
+  std::transform(first, last, first,
+                 [&](const auto c) { return city_t(new_to_old[size_t(c)]); });
+}
+
+// Inverse of restore
+template <typename CityIt>
+void renumber(CityIt first, CityIt last,
+              const std::vector<size_t> &new_to_old) {
+  using city_t = typename std::iterator_traits<CityIt>::value_type;
+  std::vector<size_t> old_to_new(new_to_old.size());
+  for (size_t i = 0; i < new_to_old.size(); i++) {
+    old_to_new[new_to_old[i]] = i;
+  }
+  std::transform(first, last, first,
+                 [&](const auto c) { return city_t(old_to_new[size_t(c)]); });
+}
+} // namespace renumbering
+
+#endif // GENETIC_TSP_RENUMBERING_HPP
@@ -0,0 +1,185 @@
+#ifndef GENETIC_TSP_SEEDING_HPP
+#define GENETIC_TSP_SEEDING_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+// Construction heuristics for initial tours. Each returns a closed tour as
+// the order in which the N cities are visited.
+namespace seeding {
+
+template <typename DistanceFn>
+std::vector<size_t> nearest_neighbour(size_t N, size_t start,
+                                      DistanceFn &&distance) {
+  std::vector<size_t> tour;
+  tour.reserve(N);
+  std::vector<bool> visited(N, false);
+  auto current = start;
+  for (size_t i = 0; i < N; i++) {
+    tour.push_back(current);
+    visited[current] = true;
+    auto next = current;
+    auto best = std::numeric_limits<double>::max();
+    for (size_t j = 0; j < N; j++) {
+      if (!visited[j] && double(distance(current, j)) < best) {
+        best = double(distance(current, j));
+        next = j;
+      }
+    }
+    current = next;
+  }
+  return tour;
+}
+
+// Greedy edge matching: edges are taken shortest first whenever both ends
+// have degree < 2 and they close no cycle, until a Hamiltonian path is left.
+template <typename DistanceFn>
+std::vector<size_t> greedy_edge(size_t N, DistanceFn &&distance) {
+  if (N < 3) {
+    std::vector<size_t> tour(N);
+    std::iota(tour.begin(), tour.end(), 0);
+    return tour;
+  }
+  std::vector<std::tuple<double, size_t, size_t>> edges;
+  edges.reserve(N * (N - 1) / 2);
+  for (size_t x = 0; x < N; x++) {
+    for (size_t y = x + 1; y < N; y++) {
+      edges.emplace_back(double(distance(x, y)), x, y);
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+
+  // Path fragments are tracked with a union-find over their cities
+  std::vector<size_t> fragment(N);
+  std::iota(fragment.begin(), fragment.end(), 0);
+  const auto root = [&](size_t x) {
+    while (fragment[x] != x) {
+      fragment[x] = fragment[fragment[x]];
+      x = fragment[x];
+    }
+    return x;
+  };
+  constexpr auto none = std::numeric_limits<size_t>::max();
+  std::vector<std::array<size_t, 2>> neighbours(N, {none, none});
+  size_t n_edges = 0;
+  for (const auto &[d, x, y] : edges) {
+    if (n_edges == N - 1)
+      break;
+    if (neighbours[x][1] != none || neighbours[y][1] != none ||
+        root(x) == root(y))
+      continue;
+    neighbours[x][neighbours[x][0] == none ? 0 : 1] = y;
+    neighbours[y][neighbours[y][0] == none ? 0 : 1] = x;
+    fragment[root(x)] = root(y);
+    n_edges++;
+  }
+
+  // Walk the path from one of its ends
+  auto current = size_t(0);
+  while (neighbours[current][1] != none)
+    current++;
+  std::vector<size_t> tour;
+  tour.reserve(N);
+  auto previous = none;
+  while (current != none) {
+    tour.push_back(current);
+    const auto next = neighbours[current][0] != previous
+                          ? neighbours[current][0]
+                          : neighbours[current][1];
+    previous = current;
+    current = next;
+  }
+  return tour;
+}
+
+// Completes a tour through some of the cities, inserting each missing city
+// where it lengthens the tour least. Each insertion costs O(N).
+template <typename DistanceFn>
+std::vector<size_t> cheapest_insertion(std::vector<size_t> tour, size_t N,
+                                       DistanceFn &&distance) {
+  std::vector<bool> visited(N, false);
+  for (const auto c : tour) {
+    visited[c] = true;
+  }
+  tour.reserve(N);
+  for (size_t x = 0; x < N; x++) {
+    if (visited[x])
+      continue;
+    auto position = tour.size();
+    auto best = std::numeric_limits<double>::max();
+    for (size_t i = 0; tour.size() > 1 && i < tour.size(); i++) {
+      const auto a = tour[i];
+      const auto b = tour[(i + 1) % tour.size()];
+      const auto cost = double(distance(a, x)) + double(distance(x, b)) -
+                        double(distance(a, b));
+      if (cost < best) {
+        best = cost;
+        position = i + 1;
+      }
+    }
+    tour.insert(std::next(tour.begin(), std::ptrdiff_t(position)), x);
+  }
+  return tour;
+}
+
+// Position of (x, y) along the Hilbert curve filling a 2^16 x 2^16 grid
+constexpr inline uint64_t hilbert_index(uint32_t x, uint32_t y) {
+  uint64_t d = 0;
+  for (uint32_t s = 1U << 15U; s > 0; s /= 2) {
+    const uint32_t rx = (x & s) > 0 ? 1 : 0;
+    const uint32_t ry = (y & s) > 0 ? 1 : 0;
+    d += uint64_t(s) * s * ((3 * rx) ^ ry);
+    // Rotate the quadrant so that the curve stays continuous
+    if (ry == 0) {
+      if (rx == 1) {
+        x = s - 1 - (x & (s - 1));
+        y = s - 1 - (y & (s - 1));
+      }
+      std::swap(x, y);
+    }
+    x &= s - 1;
+    y &= s - 1;
+  }
+  return d;
+}
+
+// Cities sorted along the Hilbert curve through the bounding box of their
+// first two coordinates
+template <typename CoordinatesIt>
+std::vector<size_t> hilbert_order(CoordinatesIt first, size_t N) {
+  std::array<double, 2> low{std::numeric_limits<double>::max(),
+                            std::numeric_limits<double>::max()};
+  std::array<double, 2> high{std::numeric_limits<double>::lowest(),
+                             std::numeric_limits<double>::lowest()};
+  for (auto it = first; it != std::next(first, std::ptrdiff_t(N)); it++) {
+    for (size_t k = 0; k < 2; k++) {
+      low[k] = std::min(low[k], double((*it)[k]));
+      high[k] = std::max(high[k], double((*it)[k]));
+    }
+  }
+  const auto grid = [&](const double value, const size_t k) {
+    const auto side = high[k] > low[k] ? high[k] - low[k] : 1.;
+    return uint32_t((value - low[k]) / side * 65535.);
+  };
+  std::vector<uint64_t> keys(N);
+  std::transform(first, std::next(first, std::ptrdiff_t(N)), keys.begin(),
+                 [&](const auto &c) {
+                   return hilbert_index(grid(double(c[0]), 0),
+                                        grid(double(c[1]), 1));
+                 });
+  std::vector<size_t> tour(N);
+  std::iota(tour.begin(), tour.end(), 0);
+  std::stable_sort(tour.begin(), tour.end(), [&](const auto a, const auto b) {
+    return keys[a] < keys[b];
+  });
+  return tour;
+}
+} // namespace seeding
+
+#endif // GENETIC_TSP_SEEDING_HPP
@@ -0,0 +1,624 @@
+#ifndef GENETIC_TSP_SERVICE_HPP
+#define GENETIC_TSP_SERVICE_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "buckets.hpp"
+#include "decomposition.hpp"
+#include "genetic_process.hpp"
+#include "instance.hpp"
+#include "metrics.hpp"
+#include "selection.hpp"
+#include "tsp_ga.hpp"
+
+// Solves requested over a Unix domain socket, by a server keeping the
+// recently used instances in memory. Messages are frames made of a 32-bit
+// length and a payload, in which numbers are stored in the native byte
+// order as both ends run on the same machine.
+namespace service {
+
+struct Request {
+  // Path of the instance file, see instance::load
+  std::string instance;
+  uint64_t seed{0};
+  uint64_t population_size{100};
+  uint64_t n_iterations{100};
+  double mutation_probability{0.05};
+  // roulette, tournament or rank
+  std::string selection{"roulette"};
+};
+
+struct Response {
+  // Empty on success
+  std::string error;
+  double length{0};
+  uint64_t n_evaluations{0};
+  double seconds{0};
+  // Best path, starting from city 0 which it does not list
+  std::vector<uint32_t> path;
+};
+
+namespace detail {
+class Writer {
+public:
+  template <typename T> void put(const T value) {
+    static_assert(std::is_arithmetic_v<T>);
+    const auto first = m_data.size();
+    m_data.resize(first + sizeof(T));
+    std::memcpy(&m_data[first], &value, sizeof(T));
+  }
+  void put(const std::string &value) {
+    put(uint32_t(value.size()));
+    m_data += value;
+  }
+
+  [[nodiscard]] const std::string &data() const { return m_data; }
+
+private:
+  std::string m_data;
+};
+
+class Reader {
+public:
+  explicit Reader(const std::string &data) : m_data(data) {}
+
+  template <typename T> T get() {
+    static_assert(std::is_arithmetic_v<T>);
+    T value;
+    std::memcpy(&value, take(sizeof(T)), sizeof(T));
+    return value;
+  }
+  std::string get_string() {
+    const auto size = get<uint32_t>();
+    return std::string(take(size), size);
+  }
+
+private:
+  const std::string &m_data;
+  size_t m_position{0};
+
+  const char *take(size_t size) {
+    if (m_data.size() - m_position < size)
+      throw std::runtime_error("Truncated message");
+    const auto first = m_data.data() + m_position;
+    m_position += size;
+    return first;
+  }
+};
+
+inline void write_all(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    const auto n = ::send(fd, data, size, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0)
+      throw std::runtime_error("Cannot write to the socket");
+    data += n;
+    size -= size_t(n);
+  }
+}
+
+// Returns false if the peer closed the connection before the first byte
+inline bool read_all(int fd, char *data, size_t size) {
+  const auto total = size;
+  while (size > 0) {
+    const auto n = ::recv(fd, data, size, 0);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0)
+      throw std::runtime_error("Cannot read from the socket");
+    if (n == 0) {
+      if (size == total)
+        return false;
+      throw std::runtime_error("Truncated frame");
+    }
+    data += n;
+    size -= size_t(n);
+  }
+  return true;
+}
+
+// Makes reads and writes that wait longer than timeout fail
+inline void set_timeout(int fd, std::chrono::milliseconds timeout) {
+  timeval limit{};
+  limit.tv_sec = time_t(timeout.count() / 1000);
+  limit.tv_usec = suseconds_t(timeout.count() % 1000 * 1000);
+  ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &limit, sizeof(limit));
+  ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &limit, sizeof(limit));
+}
+
+inline sockaddr_un address(const std::string &path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path))
+    throw std::runtime_error("Socket path too long: " + path);
+  std::copy(path.cbegin(), path.cend(), address.sun_path);
+  return address;
+}
+} // namespace detail
+
+// Owner of a socket descriptor
+class Socket {
+public:
+  Socket() = default;
+  explicit Socket(int fd) : m_fd(fd) {}
+  Socket(Socket &&other) noexcept : m_fd(std::exchange(other.m_fd, -1)) {}
+  Socket &operator=(Socket &&other) noexcept {
+    std::swap(m_fd, other.m_fd);
+    return *this;
+  }
+  ~Socket() {
+    if (m_fd >= 0)
+      ::close(m_fd);
+  }
+
+  [[nodiscard]] int fd() const { return m_fd; }
+
+private:
+  int m_fd{-1};
+};
+
+constexpr uint32_t max_frame_size = 1U << 26;
+
+inline void send_frame(const Socket &socket, const std::string &payload) {
+  const auto size = uint32_t(payload.size());
+  detail::write_all(socket.fd(), reinterpret_cast<const char *>(&size),
+                    sizeof(size));
+  detail::write_all(socket.fd(), payload.data(), payload.size());
+}
+
+// Returns false once the peer has closed the connection
+inline bool receive_frame(const Socket &socket, std::string &payload) {
+  uint32_t size{};
+  if (!detail::read_all(socket.fd(), reinterpret_cast<char *>(&size),
+                        sizeof(size)))
+    return false;
+  if (size > max_frame_size)
+    throw std::runtime_error("Frame too large");
+  payload.resize(size);
+  if (size > 0 && !detail::read_all(socket.fd(), payload.data(), size))
+    throw std::runtime_error("Truncated frame");
+  return true;
+}
+
+inline std::string encode(const Request &request) {
+  detail::Writer writer;
+  writer.put(request.instance);
+  writer.put(request.seed);
+  writer.put(request.population_size);
+  writer.put(request.n_iterations);
+  writer.put(request.mutation_probability);
+  writer.put(request.selection);
+  return writer.data();
+}
+
+inline Request decode_request(const std::string &payload) {
+  detail::Reader reader(payload);
+  Request request;
+  request.instance = reader.get_string();
+  request.seed = reader.get<uint64_t>();
+  request.population_size = reader.get<uint64_t>();
+  request.n_iterations = reader.get<uint64_t>();
+  request.mutation_probability = reader.get<double>();
+  request.selection = reader.get_string();
+  return request;
+}
+
+inline std::string encode(const Response &response) {
+  detail::Writer writer;
+  writer.put(response.error);
+  writer.put(response.length);
+  writer.put(response.n_evaluations);
+  writer.put(response.seconds);
+  writer.put(uint32_t(response.path.size()));
+  for (const auto c : response.path) {
+    writer.put(c);
+  }
+  return writer.data();
+}
+
+inline Response decode_response(const std::string &payload) {
+  detail::Reader reader(payload);
+  Response response;
+  response.error = reader.get_string();
+  response.length = reader.get<double>();
+  response.n_evaluations = reader.get<uint64_t>();
+  response.seconds = reader.get<double>();
+  response.path.resize(reader.get<uint32_t>());
+  for (auto &c : response.path) {
+    c = reader.get<uint32_t>();
+  }
+  return response;
+}
+
+inline Socket connect(const std::string &path) {
+  Socket socket(::socket(AF_UNIX, SOCK_STREAM, 0));
+  const auto address = detail::address(path);
+  if (socket.fd() < 0 ||
+      ::connect(socket.fd(), reinterpret_cast<const sockaddr *>(&address),
+                sizeof(address)) != 0)
+    throw std::runtime_error("Cannot connect to " + path);
+  return socket;
+}
+
+// Sends the request and waits for its response
+inline Response call(const Socket &socket, const Request &request) {
+  send_frame(socket, encode(request));
+  std::string payload;
+  if (!receive_frame(socket, payload))
+    throw std::runtime_error("Connection closed by the server");
+  return decode_response(payload);
+}
+
+// TSP on the instance, padded if it has fewer cities than the TSP
+template <class Problem>
+Problem make_problem(const instance::Instance &instance) {
+  using Coordinates = typename Problem::CityCoordinates::value_type;
+  std::vector<Coordinates> coordinates(instance.size());
+  std::transform(instance.coordinates.cbegin(), instance.coordinates.cend(),
+                 coordinates.begin(),
+                 [](const auto &c) { return Coordinates{c[0], c[1]}; });
+  if (instance.edge_weight_type.empty())
+    return Problem(coordinates, std::vector<double>());
+  return Problem(coordinates, instance.distances());
+}
+
+template <class Problem> Problem make_problem(const std::string &path) {
+  return make_problem<Problem>(instance::load(path));
+}
+
+// Runs the request on a copy of the prototype, which shares its distances
+template <class Problem>
+Response solve(const Problem &prototype, const Request &request) {
+  if (request.population_size == 0 || request.population_size % 2 != 0)
+    throw std::runtime_error("The population size must be even");
+  const auto run = [&](auto selection) {
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    genetic::Process gp(Problem(prototype), std::move(selection));
+    std::mt19937_64 rng(request.seed);
+    std::vector<typename Problem::Individual> population(
+        request.population_size);
+    std::vector<typename Problem::FitnessMeasure> evaluations(
+        request.population_size);
+    gp.run(population.begin(), population.size(), evaluations.begin(),
+           request.n_iterations, request.mutation_probability, rng);
+    const auto &best = population[size_t(std::distance(
+        evaluations.cbegin(),
+        std::max_element(evaluations.cbegin(), evaluations.cend())))];
+    const std::chrono::duration<double> elapsed = clock::now() - start;
+    Response response;
+    response.length = gp.ga().length(best);
+    response.n_evaluations = gp.n_evaluations();
+    response.seconds = elapsed.count();
+    // Without the padding cities
+    response.path.assign(best.cbegin(),
+                         snext(best.cbegin(), prototype.n_cities() - 1));
+    return response;
+  };
+  if (request.selection == "roulette")
+    return run(genetic::selection::Roulette());
+  if (request.selection == "tournament")
+    return run(genetic::selection::Tournament(3));
+  if (request.selection == "rank")
+    return run(genetic::selection::LinearRank(1.5));
+  throw std::runtime_error("Unknown selection policy: " + request.selection);
+}
+
+// Solves requests on one loaded instance, from any number of threads
+using Engine = std::function<Response(const Request &)>;
+
+// Instances larger than the largest bucket are split into clusters of this
+// size, see decomposition::solve
+constexpr size_t decomposition_cluster_size = 128;
+
+// Runs the request by decomposition, drawing from a std::mt19937_64 seeded
+// by the request as solve does. The cluster solves are not counted in
+// n_evaluations, and the selection policy is the one of solve_cluster.
+template <class Metric>
+Response solve_decomposed(const instance::Instance &instance,
+                          const Request &request) {
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+  std::mt19937_64 rng(request.seed);
+  const auto path = decomposition::solve<decomposition_cluster_size, Metric>(
+      instance.coordinates.cbegin(), instance.size(), request.population_size,
+      request.n_iterations, request.mutation_probability, 20, rng);
+  const std::chrono::duration<double> elapsed = clock::now() - start;
+  Response response;
+  for (size_t i = 1; i < path.size(); i++) {
+    response.length += Metric::distance(instance.coordinates[path[i - 1]],
+                                        instance.coordinates[path[i]]);
+  }
+  response.seconds = elapsed.count();
+  response.path.assign(std::next(path.cbegin()), path.cend());
+  return response;
+}
+
+// Engine solving the instance by decomposition, measured by Metric for CSV
+// files and by their edge weight type for TSPLIB ones. EXPLICIT weights
+// cannot be decomposed.
+template <class Metric>
+Engine decomposition_engine(
+    const std::shared_ptr<const instance::Instance> &instance) {
+  const auto &type = instance->edge_weight_type;
+  if (type.empty())
+    return [instance](const Request &request) {
+      return solve_decomposed<Metric>(*instance, request);
+    };
+  if (type == "EUC_2D")
+    return [instance](const Request &request) {
+      return solve_decomposed<metrics::RoundedEuclidean>(*instance, request);
+    };
+  if (type == "ATT")
+    return [instance](const Request &request) {
+      return solve_decomposed<metrics::ATT>(*instance, request);
+    };
+  if (type == "GEO")
+    return [instance](const Request &request) {
+      return solve_decomposed<metrics::Geo>(*instance, request);
+    };
+  throw std::runtime_error(instance->name + " has " +
+                           std::to_string(instance->size()) +
+                           " cities, too many for " + type + " weights");
+}
+
+// Engine for the instance file. Its TSP is instantiated for the smallest
+// of Buckets holding it, measured by Metric for CSV files and by their edge
+// weight type for TSPLIB ones, whose distances are computed once and shared
+// by the solves. Larger instances are solved by decomposition_engine.
+template <class Metric, class Buckets = buckets::Default>
+Engine make_engine(const std::string &path) {
+  auto instance = std::make_shared<const instance::Instance>(
+      instance::load(path));
+  Engine engine;
+  buckets::dispatch(Buckets{}, instance->size(), [&](auto n_cities) {
+    using Problem =
+        TSP<std::array<double, 2>, decltype(n_cities)::value, Metric>;
+    const auto problem =
+        std::make_shared<const Problem>(make_problem<Problem>(*instance));
+    engine = [problem](const Request &request) {
+      return solve(*problem, request);
+    };
+  });
+  if (engine)
+    return engine;
+  return decomposition_engine<Metric>(instance);
+}
+
+// The engines of the most recently used instances, loaded from their files
+// on demand. Evicted engines live on until the solves using them end.
+class InstanceCache {
+public:
+  using Loader = std::function<Engine(const std::string &)>;
+
+  InstanceCache(size_t capacity, Loader load)
+      : m_capacity(std::max(capacity, size_t(1))), m_load(std::move(load)) {}
+
+  std::shared_ptr<const Engine> get(const std::string &path) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (const auto found = m_index.find(path); found != m_index.end()) {
+        m_entries.splice(m_entries.begin(), m_entries, found->second);
+        return found->second->second;
+      }
+    }
+    // Loaded without the lock, not to hold up requests on cached instances
+    auto engine = std::make_shared<const Engine>(m_load(path));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_n_loads++;
+    if (const auto found = m_index.find(path); found != m_index.end())
+      return found->second->second;
+    m_entries.emplace_front(path, engine);
+    m_index[path] = m_entries.begin();
+    if (m_entries.size() > m_capacity) {
+      m_index.erase(m_entries.back().first);
+      m_entries.pop_back();
+    }
+    return engine;
+  }
+
+  [[nodiscard]] size_t n_loads() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_n_loads;
+  }
+
+private:
+  using Entry = std::pair<std::string, std::shared_ptr<const Engine>>;
+  size_t m_capacity;
+  Loader m_load;
+  std::list<Entry> m_entries{};
+  std::map<std::string, typename std::list<Entry>::iterator> m_index{};
+  size_t m_n_loads{0};
+  mutable std::mutex m_mutex{};
+};
+
+// Listens on the socket from construction. Each connection may send any
+// number of requests, answered in order. The thread of serve polls the idle
+// connections and queues those with a request, which a pool of workers
+// answer one at a time, so that open connections do not hold the workers.
+// A connection that stalls for timeout within a frame, or does not take
+// its answer, is closed. Instances are solved by make_engine<Metric,
+// Buckets>.
+template <class Metric, class Buckets = buckets::Default> class Server {
+public:
+  Server(std::string socket_path, size_t n_workers, size_t cache_capacity,
+         std::chrono::milliseconds timeout = std::chrono::seconds(5))
+      : m_path(std::move(socket_path)), m_timeout(timeout),
+        m_cache(cache_capacity, make_engine<Metric, Buckets>) {
+    m_listener = Socket(::socket(AF_UNIX, SOCK_STREAM, 0));
+    const auto address = detail::address(m_path);
+    ::unlink(m_path.c_str());
+    if (m_listener.fd() < 0 ||
+        ::bind(m_listener.fd(), reinterpret_cast<const sockaddr *>(&address),
+               sizeof(address)) != 0 ||
+        ::listen(m_listener.fd(), SOMAXCONN) != 0)
+      throw std::runtime_error("Cannot listen on " + m_path);
+    std::array<int, 2> wake{-1, -1};
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, wake.data()) != 0)
+      throw std::runtime_error("Cannot create the wake-up socket");
+    m_wake_in = Socket(wake[0]);
+    m_wake_out = Socket(wake[1]);
+    for (size_t w = 0; w < std::max(n_workers, size_t(1)); w++) {
+      m_workers.emplace_back([this]() { work(); });
+    }
+  }
+  Server(const Server &) = delete;
+  Server &operator=(const Server &) = delete;
+  ~Server() {
+    stop();
+    for (auto &worker : m_workers) {
+      worker.join();
+    }
+    ::unlink(m_path.c_str());
+  }
+
+  // Accepts connections and queues those with a request until stop is
+  // called
+  void serve() {
+    std::vector<Socket> idle;
+    std::vector<pollfd> descriptors;
+    while (!m_stopping) {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::move(m_answered.begin(), m_answered.end(),
+                  std::back_inserter(idle));
+        m_answered.clear();
+      }
+      descriptors.assign({{m_listener.fd(), POLLIN, 0},
+                          {m_wake_in.fd(), POLLIN, 0}});
+      for (const auto &connection : idle) {
+        descriptors.push_back({connection.fd(), POLLIN, 0});
+      }
+      if (::poll(descriptors.data(), nfds_t(descriptors.size()),
+                 int(tick.count())) <= 0)
+        continue;
+      if (descriptors[1].revents != 0) {
+        std::array<char, 64> drained{};
+        while (::recv(m_wake_in.fd(), drained.data(), drained.size(),
+                      MSG_DONTWAIT) > 0) {
+        }
+      }
+      // A closed connection is readable too, and ends in a worker
+      std::vector<Socket> waiting;
+      std::vector<Socket> requests;
+      for (size_t i = 0; i < idle.size(); i++) {
+        if (descriptors[i + 2].revents != 0)
+          requests.push_back(std::move(idle[i]));
+        else
+          waiting.push_back(std::move(idle[i]));
+      }
+      idle = std::move(waiting);
+      if (descriptors[0].revents != 0) {
+        Socket connection(::accept(m_listener.fd(), nullptr, nullptr));
+        if (connection.fd() >= 0) {
+          detail::set_timeout(connection.fd(), m_timeout);
+          idle.push_back(std::move(connection));
+        }
+      }
+      if (requests.empty())
+        continue;
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (auto &connection : requests) {
+        m_requests.push(std::move(connection));
+        m_ready.notify_one();
+      }
+    }
+  }
+
+  // Only sets a flag, so it can be called from a signal handler. Requests
+  // being solved are answered first.
+  void stop() { m_stopping = true; }
+
+  [[nodiscard]] size_t n_instance_loads() const { return m_cache.n_loads(); }
+
+private:
+  // Period at which blocked threads check whether the server is stopping
+  static constexpr std::chrono::milliseconds tick{100};
+  std::string m_path;
+  std::chrono::milliseconds m_timeout;
+  InstanceCache m_cache;
+  Socket m_listener{};
+  // Written by the workers to wake serve up when they hand a connection back
+  Socket m_wake_in{};
+  Socket m_wake_out{};
+  std::atomic<bool> m_stopping{false};
+  // Connections with a request, and connections answered since serve last
+  // polled
+  std::queue<Socket> m_requests{};
+  std::vector<Socket> m_answered{};
+  std::mutex m_mutex{};
+  std::condition_variable m_ready{};
+  std::vector<std::thread> m_workers{};
+
+  void work() {
+    while (!m_stopping) {
+      Socket connection;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_ready.wait_for(lock, tick,
+                              [&]() { return !m_requests.empty(); }))
+          continue;
+        connection = std::move(m_requests.front());
+        m_requests.pop();
+      }
+      try {
+        std::string payload;
+        if (!receive_frame(connection, payload))
+          continue;
+        send_frame(connection, encode(answer(payload)));
+      } catch (const std::exception &) {
+        // A broken connection only ends itself
+        continue;
+      }
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_answered.push_back(std::move(connection));
+      }
+      const char wake = 0;
+      [[maybe_unused]] const auto sent =
+          ::send(m_wake_out.fd(), &wake, 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+    }
+  }
+
+  Response answer(const std::string &payload) {
+    try {
+      const auto request = decode_request(payload);
+      return (*m_cache.get(request.instance))(request);
+    } catch (const std::exception &e) {
+      Response response;
+      response.error = e.what();
+      return response;
+    }
+  }
+};
+} // namespace service
+
+#endif // GENETIC_TSP_SERVICE_HPP
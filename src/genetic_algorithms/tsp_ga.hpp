@@ -8,8 +8,17 @@
 #include "config.hpp"
 
 #include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <numeric>
+#include <optional>
 #include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -17,47 +26,206 @@
 #include <mpi.h>
 #endif
 
+#include "bandit.hpp"
+#include "bounds.hpp"
+#include "edge_frequency.hpp"
+#include "metrics.hpp"
+#include "seeding.hpp"
+#include "two_level_list.hpp"
 #include "utils.hpp"
+#include "warm_start.hpp"
 
-template <typename Coordinates, size_t N_CITIES> class TSP {
+// Distance is the storage type of the distance table: a floating point type,
+// or an unsigned integer for a fixed-point table scaled so that no path
+// length can overflow it.
+template <typename Coordinates, size_t N_CITIES, class Metric = metrics::L1,
+          typename Distance = double>
+class TSP {
   typedef unsigned short city_index;
   // Preventing stack overflow
   static_assert(N_CITIES <= 1000);
+  static constexpr bool is_fixed_point = std::is_integral_v<Distance>;
+  static_assert(std::is_floating_point_v<Distance> ||
+                (std::is_unsigned_v<Distance> &&
+                 sizeof(Distance) >= sizeof(unsigned)));
 
 public:
   typedef std::array<city_index, N_CITIES - 1> Individual;
-  typedef double FitnessMeasure;
+  typedef std::array<Coordinates, N_CITIES> CityCoordinates;
+  typedef Distance DistanceMeasure;
+  typedef std::conditional_t<is_fixed_point, float, Distance> FitnessMeasure;
+  // XOR of the keys of the undirected edges of the path, so that it can be
+  // updated in O(1) per edge that changes
+  typedef uint64_t Hash;
+  typedef EdgeFrequency<N_CITIES> EdgeTable;
 
   TSP(TSP &&) = default;
+  // Copies share the distance table, which is never written after
+  // construction, so runs on the same instance can be set up from one TSP
+  TSP(const TSP &) = default;
   explicit TSP(const std::array<Coordinates, N_CITIES> &city_coordinates)
       : m_city_coordinates(city_coordinates),
-        m_cut_distribution(0, N_CITIES - 2) {}
+        m_cut_distribution(0, N_CITIES - 2) {
+    // The metric is only ever evaluated here: evaluations read the table
+    std::vector<double> distances(N_CITIES * N_CITIES);
+    for (size_t x = 0; x < N_CITIES; x++) {
+      for (size_t y = 0; y < x; y++) {
+        const auto d =
+            Metric::distance(m_city_coordinates[x], m_city_coordinates[y]);
+        distances[x * N_CITIES + y] = d;
+        distances[y * N_CITIES + x] = d;
+      }
+    }
+    _fill_table(distances);
+  }
+
+  // Distances given as a full N x N matrix instead of by Metric, as in an
+  // EXPLICIT TSPLIB instance. The coordinates are only used for seeding.
+  TSP(const std::array<Coordinates, N_CITIES> &city_coordinates,
+      const std::vector<double> &distances)
+      : m_city_coordinates(city_coordinates),
+        m_cut_distribution(0, N_CITIES - 2) {
+    if (distances.size() != N_CITIES * N_CITIES)
+      throw std::runtime_error("Expected a " + std::to_string(N_CITIES) +
+                               " x " + std::to_string(N_CITIES) +
+                               " distance matrix");
+    _fill_table(distances);
+  }
+
+  // Instance of n <= N_CITIES cities, so that one instantiation serves a
+  // bucket of sizes, see buckets::dispatch. The slots past n are padded
+  // with cities at distance 0 from all others, which are kept at the end of
+  // every individual in increasing order: only cuts within the first n - 1
+  // positions are drawn. Distances are an n x n matrix, or given by Metric
+  // if empty.
+  TSP(const std::vector<Coordinates> &city_coordinates,
+      const std::vector<double> &distances)
+      : m_city_coordinates(_padded(city_coordinates)),
+        m_n_cities(city_coordinates.size()),
+        m_cut_distribution(0, m_n_cities - 2) {
+    const auto n = m_n_cities;
+    if (!distances.empty() && distances.size() != n * n)
+      throw std::runtime_error("Expected a " + std::to_string(n) + " x " +
+                               std::to_string(n) + " distance matrix");
+    std::vector<double> padded(N_CITIES * N_CITIES);
+    for (size_t x = 0; x < n; x++) {
+      for (size_t y = 0; y < n; y++) {
+        padded[x * N_CITIES + y] =
+            distances.empty() ? Metric::distance(m_city_coordinates[x],
+                                                 m_city_coordinates[y])
+                              : distances[x * n + y];
+      }
+    }
+    _fill_table(padded);
+  }
+
+  // Same as the constructor above for an instance sharing cities with the
+  // one of previous, matched by new_to_old as in warm_start::match. The
+  // distances between shared cities are copied from the table of previous,
+  // so that Metric is only evaluated for the added cities. A fixed-point
+  // table holds rounded distances, so then Metric evaluates all of them.
+  template <size_t N_PREVIOUS, typename PreviousDistance>
+  TSP(const std::vector<Coordinates> &city_coordinates,
+      const TSP<Coordinates, N_PREVIOUS, Metric, PreviousDistance> &previous,
+      const std::vector<size_t> &new_to_old)
+      : TSP(city_coordinates,
+            _carried_distances(city_coordinates, previous, new_to_old)) {}
+
+  // Copy with its own distance table, written by the calling thread so that
+  // it is allocated on the NUMA node of that thread
+  [[nodiscard]] TSP replicate() const {
+    TSP copy(*this);
+    copy.m_distances =
+        std::make_shared<const std::vector<DistanceMeasure>>(*m_distances);
+    copy.m_table = copy.m_distances->data();
+    return copy;
+  }
+
+  // How generate builds the initial population. Apart from random, the
+  // heuristic tours are perturbed by a few random reflections, all but the
+  // first one. warm_start completes the tour given to set_warm_start.
+  enum class Seeding { random, nearest_neighbour, greedy, hilbert, warm_start };
+
+  void set_seeding(Seeding seeding) {
+    m_seeding = seeding;
+    m_base.reset();
+  }
+
+  // Seeds from a tour through some of the cities, such as a previous
+  // solution carried over by warm_start::carry_over. The missing cities are
+  // inserted where they lengthen it least.
+  void set_warm_start(std::vector<size_t> tour) {
+    m_warm_tour = std::move(tour);
+    m_seeding = Seeding::warm_start;
+    m_base.reset();
+  }
 
   template <typename PopulationIt, class RNG>
   void generate(PopulationIt first_individual, size_t N, RNG &rng) {
-    Individual base;
-    std::iota(base.begin(), base.end(), 1);
-    std::for_each(first_individual, snext(first_individual, N),
-                  [&](Individual &i) {
-                    std::copy(base.cbegin(), base.cend(), i.begin());
-                    std::shuffle(i.begin(), i.end(), rng);
-                  });
+    generate(first_individual, N, rng, 0);
   }
 
-  FitnessMeasure evaluate(const Individual &individual) {
-    // The first city is fixed
-    FitnessMeasure total_distance{distance_l1(0, *individual.cbegin())};
-#if __cplusplus >= 202002L
-    total_distance = std::transform_reduce(
-        individual.cbegin(), std::prev(individual.cend()),
-        std::next(individual.cbegin()), total_distance, std::plus<>(),
-        [&](const auto i, const auto j) { return distance_l1(i, j); });
-#else
-    for (auto i = std::next(individual.cbegin()); i < individual.cend(); i++) {
-      total_distance += distance_l1(*i, *std::prev(i));
+  // Same as generate, for the N individuals from position offset on of a
+  // population generated in parts, such as by several threads. The tour
+  // that the seeding perturbs is built once, on the first call.
+  template <typename PopulationIt, class RNG>
+  void generate(PopulationIt first_individual, size_t N, RNG &rng,
+                size_t offset) {
+    const auto distance_fn = [&](const size_t x, const size_t y) {
+      return distance(x, y);
+    };
+    const auto n = m_n_cities;
+    std::uniform_int_distribution<size_t> start(0, n - 1);
+    const auto &base = _base();
+    for (size_t i = 0; i < N; i++) {
+      auto &individual = *snext(first_individual, i);
+      if (m_seeding == Seeding::random) {
+        std::copy(base.cbegin(), base.cend(), individual.begin());
+        std::shuffle(individual.begin(), snext(individual.begin(), n - 1),
+                     rng);
+        continue;
+      }
+      if (m_seeding == Seeding::nearest_neighbour)
+        individual = _from_tour(
+            seeding::nearest_neighbour(n, start(rng), distance_fn));
+      else
+        individual = base;
+      if (offset + i > 0)
+        _perturb(individual, rng);
     }
-#endif
-    return static_cast<FitnessMeasure>(1) / total_distance;
+  }
+
+  FitnessMeasure evaluate(const Individual &individual) {
+    return static_cast<FitnessMeasure>(m_scale) /
+           static_cast<FitnessMeasure>(path_distance(individual));
+  }
+
+  // Path length in the units of Metric
+  [[nodiscard]] double length(const Individual &individual) const {
+    return double(path_distance(individual)) / m_scale;
+  }
+
+  // Held-Karp lower bound on the length of any individual, in the units of
+  // Metric. Each iteration costs O(N^2).
+  [[nodiscard]] double lower_bound(size_t n_iterations = 1000) const {
+    const auto distance_fn = [&](const size_t x, const size_t y) {
+      return double(distance(x, y)) / m_scale;
+    };
+    const auto nearest_neighbour =
+        _from_tour(seeding::nearest_neighbour(m_n_cities, 0, distance_fn));
+    return bounds::held_karp(m_n_cities, distance_fn,
+                             length(nearest_neighbour), n_iterations);
+  }
+
+  // Number of cities of the instance, less than N_CITIES if padded
+  [[nodiscard]] size_t n_cities() const { return m_n_cities; }
+
+  // Edge frequencies over the cities of the instance, without the padding
+  [[nodiscard]] EdgeTable edge_table() const { return EdgeTable(m_n_cities); }
+
+  // Fitness of an individual as long as the given length
+  [[nodiscard]] static FitnessMeasure fitness_of(double length) {
+    return static_cast<FitnessMeasure>(1. / length);
   }
 
   template <typename PopulationIt, typename EvaluationsIt, typename OutPopIt,
@@ -72,24 +240,116 @@ public:
     });
   }
 
+  // Writes the children of the parents to child_1 and child_2, which must
+  // be other individuals than the parents: each child keeps the head of its
+  // parent, and the cities of the tail in the order they have in the other
+  // parent. Every city of a child is written once.
+  template <class RNG>
+  void crossover(const Individual &parent_1, const Individual &parent_2,
+                 Individual &child_1, Individual &child_2, RNG &rng) {
+    _crossover(parent_1, parent_2, child_1, child_2, m_cut_distribution(rng));
+  }
+
+  // Same as crossover, also turning the parents hashes into the children ones
   template <class RNG>
-  auto crossover(const Individual &parent_1, const Individual &parent_2,
-                 RNG &rng) {
-    using std::next;
-    Individual child_1(parent_1), child_2(parent_2);
+  void crossover(const Individual &parent_1, const Individual &parent_2,
+                 Individual &child_1, Individual &child_2, Hash &hash_1,
+                 Hash &hash_2, RNG &rng) {
     const auto cut = m_cut_distribution(rng);
-    swap_order_by_rank(snext(child_1.begin(), cut), child_1.end(),
-                       snext(child_2.begin(), cut));
-    return std::make_pair(child_1, child_2);
+    hash_1 ^= _hash_from(parent_1, cut);
+    hash_2 ^= _hash_from(parent_2, cut);
+    _crossover(parent_1, parent_2, child_1, child_2, cut);
+    hash_1 ^= _hash_from(child_1, cut);
+    hash_2 ^= _hash_from(child_2, cut);
   }
 
   template <class RNG> void mutate(Individual &individual, RNG &rng) {
-    const auto roll = m_mutation_distribution(rng);
-    if (roll == 0) {
-      _mutate_reflect(individual, rng);
-    } else if (roll == 1) {
-      _mutate_shift(individual, rng);
+    Hash unused{};
+    mutate(individual, unused, rng);
+  }
+
+  template <class RNG>
+  void mutate(Individual &individual, Hash &hash, RNG &rng) {
+    if (m_adaptive_operators) {
+      // Credit is the shortening of the path per second spent
+      using clock = std::chrono::steady_clock;
+      const auto roll = m_operators.choose(rng);
+      const auto start = clock::now();
+      const auto delta = roll == 0 ? _mutate_reflect(individual, hash, rng)
+                                   : _mutate_shift(individual, hash, rng);
+      const std::chrono::duration<double> elapsed = clock::now() - start;
+      m_operators.reward(roll, std::max(-delta, 0.) /
+                                   std::max(elapsed.count(), 1e-9));
+    } else {
+      const auto roll = m_mutation_distribution(rng);
+      if (roll == 0) {
+        _mutate_reflect(individual, hash, rng);
+      } else if (roll == 1) {
+        _mutate_shift(individual, hash, rng);
+      }
+    }
+    if (m_local_search_trials > 0 &&
+        two_opt(individual, m_local_search_trials, rng) > 0)
+      hash = _hash_from(individual, 0);
+  }
+
+  // Whether mutate picks reflection or shift by their recent payoff instead
+  // of evenly
+  void set_adaptive_operators(bool adaptive) {
+    m_adaptive_operators = adaptive;
+  }
+  // Probabilities of reflection and shift
+  [[nodiscard]] const std::vector<double> &operator_probabilities() const {
+    return m_operators.probabilities();
+  }
+
+  // Number of random 2-opt moves tried after each mutation, 0 to disable
+  void set_local_search(size_t n_trials) { m_local_search_trials = n_trials; }
+
+  // Tries n_trials random 2-opt moves, applying the improving ones, and
+  // returns how many were applied. The individual is moved to a two-level
+  // list once, so that each reversal costs O(sqrt(N)) instead of O(N).
+  template <class RNG>
+  size_t two_opt(Individual &individual, size_t n_trials, RNG &rng) {
+    std::array<city_index, N_CITIES> tour;
+    tour[0] = 0;
+    std::copy(individual.cbegin(), individual.cend(), std::next(tour.begin()));
+    m_tour.assign(tour.cbegin(), tour.cend());
+    // The path is the tour cut right before city 0
+    const auto cost = [&](const size_t x, const size_t y) {
+      return y == 0 ? 0. : double(distance(x, y));
+    };
+    // Padding cities, after the last one, are never moved
+    std::uniform_int_distribution<size_t> city(0, m_n_cities - 1);
+    size_t n_moves = 0;
+    for (size_t trial = 0; trial < n_trials; trial++) {
+      const auto a = city(rng);
+      const auto c = city(rng);
+      const auto a_next = m_tour.next(a);
+      const auto c_next = m_tour.next(c);
+      // City 0 must stay outside of the reversed path a_next..c
+      if (a == c || a_next == c || a_next == 0 ||
+          m_tour.between(a_next, 0, c))
+        continue;
+      const auto gain = cost(a, a_next) + cost(c, c_next) - cost(a, c) -
+                        cost(a_next, c_next);
+      if (gain > 0) {
+        m_tour.reverse(a_next, c);
+        n_moves++;
+      }
+    }
+    if (n_moves > 0) {
+      auto c = m_tour.next(0);
+      for (auto &i : individual) {
+        i = city_index(c);
+        c = m_tour.next(c);
+      }
     }
+    return n_moves;
+  }
+
+  [[nodiscard]] Hash hash(const Individual &individual) const {
+    return _hash_from(individual, 0);
   }
 
 #ifdef USE_MPI
@@ -99,48 +359,277 @@ public:
     MPI_Type_commit(&i_m);
     return i_m;
   }
+
+  static MPI_Datatype fitness_mpi() {
+    if constexpr (std::is_same_v<FitnessMeasure, float>)
+      return MPI_FLOAT;
+    else if constexpr (std::is_same_v<FitnessMeasure, double>)
+      return MPI_DOUBLE;
+    else
+      return MPI_LONG_DOUBLE;
+  }
 #endif
 
 private:
+  // Warm starts read the distances of other instances
+  template <typename, size_t, class, typename> friend class TSP;
+
   const std::array<Coordinates, N_CITIES> m_city_coordinates;
+  size_t m_n_cities{N_CITIES};
+  std::shared_ptr<const std::vector<DistanceMeasure>> m_distances;
+  // Data of the shared table, saving an indirection on every distance
+  const DistanceMeasure *m_table{nullptr};
+  // Fixed-point table units per Metric unit
+  double m_scale{1};
   std::uniform_int_distribution<size_t> m_cut_distribution;
   std::uniform_int_distribution<unsigned short> m_mutation_distribution{0, 1};
+  Seeding m_seeding{Seeding::random};
+  std::vector<size_t> m_warm_tour{};
+  std::optional<Individual> m_base{};
+  size_t m_local_search_trials{0};
+  bool m_adaptive_operators{false};
+  genetic::Bandit m_operators{2};
+  TwoLevelList m_tour{};
+  // Crossover scratch, by tail: whether each city is in it, its rank among
+  // the cities of the tail, and these cities in increasing order
+  std::vector<uint8_t> m_in_tail = std::vector<uint8_t>(2 * N_CITIES, 0);
+  std::vector<city_index> m_tail_ranks = std::vector<city_index>(2 * N_CITIES);
+  std::vector<city_index> m_sorted_tails =
+      std::vector<city_index>(2 * N_CITIES);
+
+  // The tails from cut swap their order by rank, as by swap_order_by_rank,
+  // with the ranks counted over the cities rather than sorted
+  void _crossover(const Individual &parent_1, const Individual &parent_2,
+                  Individual &child_1, Individual &child_2, const size_t cut) {
+    std::copy_n(parent_1.cbegin(), cut, child_1.begin());
+    std::copy_n(parent_2.cbegin(), cut, child_2.begin());
+    for (auto i = cut; i < N_CITIES - 1; i++) {
+      m_in_tail[parent_1[i]] = 1;
+      m_in_tail[N_CITIES + parent_2[i]] = 1;
+    }
+    std::array<city_index, 2> n_ranked{0, 0};
+    for (size_t city = 1; city < N_CITIES; city++) {
+      for (size_t tail = 0; tail < 2; tail++) {
+        const auto k = tail * N_CITIES + city;
+        if (m_in_tail[k] == 0)
+          continue;
+        m_in_tail[k] = 0;
+        m_tail_ranks[k] = n_ranked[tail];
+        m_sorted_tails[tail * N_CITIES + n_ranked[tail]++] = city_index(city);
+      }
+    }
+    for (auto i = cut; i < N_CITIES - 1; i++) {
+      child_1[i] = m_sorted_tails[m_tail_ranks[N_CITIES + parent_2[i]]];
+      child_2[i] = m_sorted_tails[N_CITIES + m_tail_ranks[parent_1[i]]];
+    }
+  }
+
+  void _fill_table(const std::vector<double> &distances) {
+    if constexpr (is_fixed_point) {
+      const auto max_distance =
+          *std::max_element(distances.cbegin(), distances.cend());
+      if (max_distance > 0)
+        m_scale = double(std::numeric_limits<Distance>::max()) /
+                  (double(N_CITIES) * max_distance);
+    }
+    std::vector<DistanceMeasure> table(N_CITIES * N_CITIES);
+    std::transform(distances.cbegin(), distances.cend(), table.begin(),
+                   [&](const double d) {
+                     if constexpr (is_fixed_point)
+                       return Distance(std::llround(d * m_scale));
+                     else
+                       return Distance(d);
+                   });
+    m_distances = std::make_shared<const std::vector<DistanceMeasure>>(
+        std::move(table));
+    m_table = m_distances->data();
+  }
+
+  // Distances between the given cities, copied from previous for those
+  // matched by new_to_old
+  template <size_t N_PREVIOUS, typename PreviousDistance>
+  [[nodiscard]] static std::vector<double> _carried_distances(
+      const std::vector<Coordinates> &city_coordinates,
+      const TSP<Coordinates, N_PREVIOUS, Metric, PreviousDistance> &previous,
+      const std::vector<size_t> &new_to_old) {
+    const auto n = city_coordinates.size();
+    if (new_to_old.size() != n)
+      throw std::runtime_error("Expected a matching of " + std::to_string(n) +
+                               " cities");
+    std::vector<double> distances(n * n);
+    for (size_t x = 0; x < n; x++) {
+      for (size_t y = 0; y < x; y++) {
+        const auto old_x = new_to_old[x];
+        const auto old_y = new_to_old[y];
+        const auto d =
+            !previous.is_fixed_point && old_x != warm_start::none &&
+                    old_y != warm_start::none
+                ? double(previous.distance(old_x, old_y))
+                : Metric::distance(city_coordinates[x], city_coordinates[y]);
+        distances[x * n + y] = d;
+        distances[y * n + x] = d;
+      }
+    }
+    return distances;
+  }
+
+  // The first n cities, followed by copies of the first one
+  [[nodiscard]] static std::array<Coordinates, N_CITIES>
+  _padded(const std::vector<Coordinates> &city_coordinates) {
+    const auto n = city_coordinates.size();
+    if (n < 2 || n > N_CITIES)
+      throw std::runtime_error("Expected between 2 and " +
+                               std::to_string(N_CITIES) + " cities, not " +
+                               std::to_string(n));
+    std::array<Coordinates, N_CITIES> padded;
+    std::copy(city_coordinates.cbegin(), city_coordinates.cend(),
+              padded.begin());
+    std::fill(snext(padded.begin(), n), padded.end(), city_coordinates[0]);
+    return padded;
+  }
+
+  // The seed tour, computed once per strategy. nearest_neighbour restarts
+  // from a random city for each individual instead.
+  const Individual &_base() {
+    if (m_base)
+      return *m_base;
+    const auto distance_fn = [&](const size_t x, const size_t y) {
+      return distance(x, y);
+    };
+    const auto n = m_n_cities;
+    Individual base;
+    switch (m_seeding) {
+    case Seeding::random:
+    case Seeding::nearest_neighbour:
+      std::iota(base.begin(), base.end(), 1);
+      break;
+    case Seeding::greedy:
+      base = _from_tour(seeding::greedy_edge(n, distance_fn));
+      break;
+    case Seeding::hilbert:
+      base = _from_tour(
+          seeding::hilbert_order(m_city_coordinates.cbegin(), n));
+      break;
+    case Seeding::warm_start:
+      base =
+          _from_tour(seeding::cheapest_insertion(m_warm_tour, n, distance_fn));
+      break;
+    }
+    return m_base.emplace(base);
+  }
+
+  // The path starting from city 0 along a closed tour through the first n
+  // cities, followed by the padding ones
+  [[nodiscard]] Individual _from_tour(const std::vector<size_t> &tour) const {
+    const auto zero = std::find(tour.cbegin(), tour.cend(), size_t(0));
+    Individual individual;
+    auto out = std::transform(std::next(zero), tour.cend(), individual.begin(),
+                              [](const auto c) { return city_index(c); });
+    out = std::transform(tour.cbegin(), zero, out,
+                         [](const auto c) { return city_index(c); });
+    std::iota(out, individual.end(), city_index(m_n_cities));
+    return individual;
+  }
+
+  template <class RNG> void _perturb(Individual &individual, RNG &rng) {
+    std::uniform_int_distribution<size_t> n_reflections(1, 1 + m_n_cities / 20);
+    Hash unused{};
+    for (auto k = n_reflections(rng); k > 0; k--) {
+      _mutate_reflect(individual, unused, rng);
+    }
+  }
 
-  template <class RNG> void _mutate_reflect(Individual &individual, RNG &rng) {
+  // The mutations return the change of the path length, in table units
+  template <class RNG>
+  double _mutate_reflect(Individual &individual, Hash &hash, RNG &rng) {
     auto i1 = m_cut_distribution(rng);
     auto i2 = m_cut_distribution(rng);
     if (i1 > i2) {
       std::swap(i1, i2);
     }
+    // Only the edges at the boundaries of the reversed range change
+    hash ^= _edge_hash(individual, i1) ^ _edge_hash(individual, i2);
+    auto delta = -_edge_length(individual, i1) - _edge_length(individual, i2);
     std::reverse(std::next(individual.begin(), int(i1)),
                  std::next(individual.begin(), int(i2)));
+    hash ^= _edge_hash(individual, i1) ^ _edge_hash(individual, i2);
+    delta += _edge_length(individual, i1) + _edge_length(individual, i2);
+    return delta;
   }
-  template <class RNG> void _mutate_shift(Individual &individual, RNG &rng) {
-    using std::next;
-    std::vector<int> cuts(4);
+  template <class RNG>
+  double _mutate_shift(Individual &individual, Hash &hash, RNG &rng) {
+    std::array<size_t, 4> cuts;
     std::generate(cuts.begin(), cuts.end(),
-                  [&]() { return int(m_cut_distribution(rng)); });
+                  [&]() { return m_cut_distribution(rng); });
     std::sort(cuts.begin(), cuts.end());
     auto first = individual.begin();
     const auto length = std::min(cuts[1] - cuts[0], cuts[3] - cuts[2]);
-    std::swap_ranges(next(first, cuts[0]), next(first, cuts[0] + length),
-                     next(first, cuts[2]));
+    // Edges at the boundaries of the swapped ranges, counted once each
+    std::array<size_t, 4> edges{cuts[0], cuts[0] + length, cuts[2],
+                                cuts[2] + length};
+    std::sort(edges.begin(), edges.end());
+    const auto last_edge = std::unique(edges.begin(), edges.end());
+    double delta = 0;
+    const auto rehash = [&](const double sign) {
+      std::for_each(edges.begin(), last_edge, [&](const auto e) {
+        hash ^= _edge_hash(individual, e);
+        delta += sign * _edge_length(individual, e);
+      });
+    };
+    rehash(-1);
+    std::swap_ranges(snext(first, cuts[0]), snext(first, cuts[0] + length),
+                     snext(first, cuts[2]));
+    rehash(1);
+    return delta;
+  }
+
+  // Key of the edge entering position i, 0 past the end of the path
+  [[nodiscard]] static inline Hash _edge_hash(const Individual &individual,
+                                              const size_t i) {
+    if (i >= individual.size())
+      return 0;
+    const size_t from = i == 0 ? 0 : individual[i - 1];
+    const size_t to = individual[i];
+    return splitmix64(std::min(from, to) * N_CITIES + std::max(from, to));
   }
 
-  [[nodiscard]] FitnessMeasure distance_l1(const size_t x,
-                                           const size_t y) const {
+  // Length of the edge entering position i, 0 past the end of the path
+  [[nodiscard]] inline double _edge_length(const Individual &individual,
+                                           const size_t i) const {
+    if (i >= individual.size())
+      return 0;
+    return double(distance(i == 0 ? 0 : individual[i - 1], individual[i]));
+  }
+
+  [[nodiscard]] static Hash _hash_from(const Individual &individual,
+                                       const size_t first) {
+    Hash hash{};
+    for (auto i = first; i < individual.size(); i++) {
+      hash ^= _edge_hash(individual, i);
+    }
+    return hash;
+  }
+
+  [[nodiscard]] inline DistanceMeasure distance(const size_t x,
+                                                const size_t y) const {
+    return m_table[x * N_CITIES + y];
+  }
+
+  [[nodiscard]] DistanceMeasure
+  path_distance(const Individual &individual) const {
+    // The first city is fixed
+    DistanceMeasure total_distance{distance(0, *individual.cbegin())};
 #if __cplusplus >= 202002L
-    return std::transform_reduce(
-        std::cbegin(m_city_coordinates[x]), std::cend(m_city_coordinates[x]),
-        std::cbegin(m_city_coordinates[y]), FitnessMeasure(0), std::plus<>(),
-        [](const auto xi, const auto yi) { return std::abs(xi - yi); });
+    total_distance = std::transform_reduce(
+        individual.cbegin(), std::prev(individual.cend()),
+        std::next(individual.cbegin()), total_distance, std::plus<>(),
+        [&](const auto i, const auto j) { return distance(i, j); });
 #else
-    FitnessMeasure distance = 0;
-    for (auto i = 0U; i < m_city_coordinates[x].size(); i++) {
-      distance += std::abs(m_city_coordinates[x][i] - m_city_coordinates[y][i]);
+    for (auto i = std::next(individual.cbegin()); i < individual.cend(); i++) {
+      total_distance += distance(*i, *std::prev(i));
     }
-    return distance;
 #endif
+    return total_distance;
   }
 };
 
@@ -0,0 +1,214 @@
+#ifndef GENETIC_TSP_TWO_LEVEL_LIST_HPP
+#define GENETIC_TSP_TWO_LEVEL_LIST_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include "utils.hpp"
+
+// Closed tour split into ~sqrt(N) segments, each with its own orientation
+// bit, kept in a sequence of segments. next, prev and between are O(1);
+// reversing a path splits at most two segments and reverses the sequence of
+// the segments in between, so it costs O(sqrt(N)).
+class TwoLevelList {
+public:
+  TwoLevelList() = default;
+
+  // Cities in tour order
+  template <typename CityIt> void assign(CityIt first, CityIt last) {
+    std::vector<size_t> tour;
+    std::transform(first, last, std::back_inserter(tour),
+                   [](const auto c) { return size_t(c); });
+    m_segment_size =
+        std::max(size_t(std::sqrt(double(tour.size()))), size_t(8));
+    m_segment_of.resize(tour.size());
+    m_index_of.resize(tour.size());
+    m_reversed = false;
+    build(tour);
+  }
+
+  [[nodiscard]] size_t size() const { return m_segment_of.size(); }
+
+  [[nodiscard]] size_t next(size_t c) const {
+    return m_reversed ? raw_prev(c) : raw_next(c);
+  }
+
+  [[nodiscard]] size_t prev(size_t c) const {
+    return m_reversed ? raw_next(c) : raw_prev(c);
+  }
+
+  // Whether b lies on the path going forward from a to c, ends included
+  [[nodiscard]] bool between(size_t a, size_t b, size_t c) const {
+    return m_reversed ? raw_between(c, b, a) : raw_between(a, b, c);
+  }
+
+  // Reverses the path going forward from a to b
+  void reverse(size_t a, size_t b) {
+    if (m_reversed)
+      std::swap(a, b);
+    if (raw_prev(a) == b) {
+      // The whole tour
+      m_reversed = !m_reversed;
+      return;
+    }
+    split_before(a);
+    split_before(raw_next(b));
+    // The path is now made of whole segments, ranks first to last cyclically
+    const auto first = m_segments[m_segment_of[a]].rank;
+    const auto last = m_segments[m_segment_of[b]].rank;
+    const auto n = m_order.size();
+    const auto length = (last + n - first) % n + 1;
+    for (size_t i = 0; i < length / 2; i++) {
+      std::swap(m_order[(first + i) % n],
+                m_order[(first + length - 1 - i) % n]);
+    }
+    for (size_t i = 0; i < length; i++) {
+      const auto rank = (first + i) % n;
+      auto &segment = m_segments[m_order[rank]];
+      segment.reversed = !segment.reversed;
+      segment.rank = rank;
+    }
+    if (m_order.size() > 3 * (size() / m_segment_size + 1))
+      rebalance();
+  }
+
+  // Writes the tour going forward from the given city
+  template <typename OutputIt>
+  OutputIt write(size_t from, OutputIt first_out) const {
+    auto c = from;
+    for (size_t i = 0; i < size(); i++) {
+      *first_out++ = c;
+      c = next(c);
+    }
+    return first_out;
+  }
+
+private:
+  struct Segment {
+    std::vector<size_t> cities;
+    bool reversed;
+    size_t rank;
+  };
+  std::vector<Segment> m_segments{};
+  // Segment ids in tour order
+  std::vector<size_t> m_order{};
+  std::vector<size_t> m_segment_of{};
+  std::vector<size_t> m_index_of{};
+  size_t m_segment_size{8};
+  bool m_reversed{false};
+
+  void build(const std::vector<size_t> &tour) {
+    m_segments.clear();
+    m_order.clear();
+    for (size_t first = 0; first < tour.size(); first += m_segment_size) {
+      const auto last = std::min(first + m_segment_size, tour.size());
+      Segment segment{std::vector<size_t>(snext(tour.cbegin(), first),
+                                          snext(tour.cbegin(), last)),
+                      false, m_order.size()};
+      m_order.push_back(m_segments.size());
+      m_segments.push_back(std::move(segment));
+      index(m_segments.size() - 1);
+    }
+  }
+
+  void rebalance() {
+    std::vector<size_t> tour;
+    tour.reserve(size());
+    const auto reversed = m_reversed;
+    m_reversed = false;
+    write(oriented_first(m_order[0]), std::back_inserter(tour));
+    build(tour);
+    m_reversed = reversed;
+  }
+
+  void index(size_t s) {
+    const auto &cities = m_segments[s].cities;
+    for (size_t i = 0; i < cities.size(); i++) {
+      m_segment_of[cities[i]] = s;
+      m_index_of[cities[i]] = i;
+    }
+  }
+
+  // Position of c within its segment, in tour order
+  [[nodiscard]] size_t oriented_index(size_t c) const {
+    const auto &segment = m_segments[m_segment_of[c]];
+    return segment.reversed ? segment.cities.size() - 1 - m_index_of[c]
+                            : m_index_of[c];
+  }
+
+  [[nodiscard]] size_t at(const Segment &segment, size_t i) const {
+    return segment.reversed ? segment.cities[segment.cities.size() - 1 - i]
+                            : segment.cities[i];
+  }
+
+  [[nodiscard]] size_t oriented_first(size_t s) const {
+    return at(m_segments[s], 0);
+  }
+
+  [[nodiscard]] size_t raw_next(size_t c) const {
+    const auto &segment = m_segments[m_segment_of[c]];
+    const auto i = oriented_index(c);
+    if (i + 1 < segment.cities.size())
+      return at(segment, i + 1);
+    return oriented_first(m_order[(segment.rank + 1) % m_order.size()]);
+  }
+
+  [[nodiscard]] size_t raw_prev(size_t c) const {
+    const auto &segment = m_segments[m_segment_of[c]];
+    const auto i = oriented_index(c);
+    if (i > 0)
+      return at(segment, i - 1);
+    const auto &previous =
+        m_segments[m_order[(segment.rank + m_order.size() - 1) %
+                           m_order.size()]];
+    return at(previous, previous.cities.size() - 1);
+  }
+
+  [[nodiscard]] bool precedes(size_t a, size_t b) const {
+    const auto ra = m_segments[m_segment_of[a]].rank;
+    const auto rb = m_segments[m_segment_of[b]].rank;
+    return ra < rb || (ra == rb && oriented_index(a) <= oriented_index(b));
+  }
+
+  [[nodiscard]] bool raw_between(size_t a, size_t b, size_t c) const {
+    if (precedes(a, c))
+      return precedes(a, b) && precedes(b, c);
+    return precedes(a, b) || precedes(b, c);
+  }
+
+  // Splits the segment of c so that c is the first city of a segment
+  void split_before(size_t c) {
+    const auto s = m_segment_of[c];
+    const auto k = oriented_index(c);
+    if (k == 0)
+      return;
+    auto &segment = m_segments[s];
+    const auto n = segment.cities.size();
+    // The cities from c onwards, in storage order
+    std::vector<size_t> tail;
+    if (segment.reversed) {
+      tail.assign(segment.cities.cbegin(),
+                  snext(segment.cities.cbegin(), n - k));
+      segment.cities.erase(segment.cities.begin(),
+                           snext(segment.cities.begin(), n - k));
+    } else {
+      tail.assign(snext(segment.cities.cbegin(), k), segment.cities.cend());
+      segment.cities.resize(k);
+    }
+    const auto reversed = segment.reversed;
+    const auto rank = segment.rank + 1;
+    m_segments.push_back(Segment{std::move(tail), reversed, rank});
+    const auto t = m_segments.size() - 1;
+    m_order.insert(snext(m_order.begin(), rank), t);
+    for (auto r = rank + 1; r < m_order.size(); r++) {
+      m_segments[m_order[r]].rank = r;
+    }
+    index(s);
+    index(t);
+  }
+};
+
+#endif // GENETIC_TSP_TWO_LEVEL_LIST_HPP
@@ -0,0 +1,64 @@
+#ifndef GENETIC_TSP_WARM_START_HPP
+#define GENETIC_TSP_WARM_START_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <utility>
+#include <vector>
+
+// Carrying a solution over to an instance that differs from the previous
+// one by a few cities. Cities are matched by their coordinates, and a
+// matching is stored as new_to_old: new_to_old[i] is the id of city i in the
+// previous instance, or none for an added city.
+namespace warm_start {
+
+constexpr auto none = std::numeric_limits<size_t>::max();
+
+template <typename PreviousIt, typename CoordinatesIt>
+std::vector<size_t> match(PreviousIt first_previous, size_t n_previous,
+                          CoordinatesIt first, size_t N) {
+  std::multimap<std::pair<double, double>, size_t> previous_ids;
+  for (size_t i = 0; i < n_previous; i++) {
+    const auto &c = *std::next(first_previous, std::ptrdiff_t(i));
+    previous_ids.emplace(std::make_pair(double(c[0]), double(c[1])), i);
+  }
+  std::vector<size_t> new_to_old(N, none);
+  for (size_t i = 0; i < N; i++) {
+    const auto &c = *std::next(first, std::ptrdiff_t(i));
+    const auto found =
+        previous_ids.find(std::make_pair(double(c[0]), double(c[1])));
+    // Each previous city is matched once, even if it was duplicated
+    if (found != previous_ids.end()) {
+      new_to_old[i] = found->second;
+      previous_ids.erase(found);
+    }
+  }
+  return new_to_old;
+}
+
+// The previous tour through the cities that are left, in the new ids. The
+// added cities can then be inserted by seeding::cheapest_insertion.
+inline std::vector<size_t> carry_over(const std::vector<size_t> &tour,
+                                      const std::vector<size_t> &new_to_old) {
+  if (tour.empty())
+    return {};
+  const auto n_previous = *std::max_element(tour.cbegin(), tour.cend()) + 1;
+  std::vector<size_t> old_to_new(n_previous, none);
+  for (size_t i = 0; i < new_to_old.size(); i++) {
+    if (new_to_old[i] < old_to_new.size())
+      old_to_new[new_to_old[i]] = i;
+  }
+  std::vector<size_t> carried;
+  carried.reserve(tour.size());
+  for (const auto c : tour) {
+    if (old_to_new[c] != none)
+      carried.push_back(old_to_new[c]);
+  }
+  return carried;
+}
+} // namespace warm_start
+
+#endif // GENETIC_TSP_WARM_START_HPP
@@ -0,0 +1,47 @@
+#include <iostream>
+#include <string>
+
+#include <cxxopts.hpp>
+
+#include "genetic_algorithms/service.hpp"
+
+// Sends one request to solver_daemon and prints the best path
+int main(int argc, char *argv[]) {
+  cxxopts::Options options("Solver client", "Request a solve from the daemon");
+  using cxxopts::value;
+  // clang-format off
+  options.add_options()
+      ("s,socket", "Socket path", value<std::string>()->default_value("/tmp/genetic_tsp.sock"))
+      ("f,file", "Instance file, as seen by the daemon", value<std::string>())
+      ("e,seed", "Random seed", value<uint64_t>()->default_value("0"))
+      ("p,population_size", "Population size", value<uint64_t>()->default_value("100"))
+      ("m,n_iterations", "Number of iterations", value<uint64_t>()->default_value("100"))
+      ("u,mutation_probability", "Mutation probability", value<double>()->default_value("0.05"))
+      ("S,selection", "Parent selection: roulette, tournament or rank", value<std::string>()->default_value("roulette"))
+      ("h,help", "Print this message");
+  // clang-format on
+  auto result = options.parse(argc, argv);
+  if (result.count("help") || !result.count("file")) {
+    std::cout << options.help() << std::endl;
+    exit(0);
+  }
+
+  const service::Request request{
+      result["f"].as<std::string>(),  result["e"].as<uint64_t>(),
+      result["p"].as<uint64_t>(),     result["m"].as<uint64_t>(),
+      result["u"].as<double>(),       result["S"].as<std::string>()};
+  const auto connection = service::connect(result["s"].as<std::string>());
+  const auto response = service::call(connection, request);
+  if (!response.error.empty()) {
+    std::cerr << response.error << '\n';
+    return 1;
+  }
+  std::cout << "Length: " << response.length << " after "
+            << response.n_evaluations << " evaluations in " << response.seconds
+            << " s\n";
+  for (const auto c : response.path) {
+    std::cout << c << ' ';
+  }
+  std::cout << '\n';
+  return 0;
+}
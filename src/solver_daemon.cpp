@@ -0,0 +1,58 @@
+#include <algorithm>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <cxxopts.hpp>
+
+#include "config.hpp"
+#include "genetic_algorithms/metrics.hpp"
+#include "genetic_algorithms/service.hpp"
+
+// CSV instances are (longitude, latitude) pairs
+using Server = service::Server<metrics::GreatCircle>;
+
+namespace {
+Server *server = nullptr;
+
+void stop(int) {
+  if (server)
+    server->stop();
+}
+} // namespace
+
+// Serves solves over a Unix domain socket until interrupted, see
+// solver_client for the requests
+int main(int argc, char *argv[]) {
+  cxxopts::Options options("Solver daemon",
+                           "Serve solves over a Unix domain socket");
+  using cxxopts::value;
+  // clang-format off
+  options.add_options()
+      ("s,socket", "Socket path", value<std::string>()->default_value("/tmp/genetic_tsp.sock"))
+      ("t,threads", "Worker threads, 0 for one per hardware thread", value<size_t>()->default_value("0"))
+      ("c,cache_size", "Instances kept in memory", value<size_t>()->default_value("16"))
+      ("h,help", "Print this message");
+  // clang-format on
+  auto result = options.parse(argc, argv);
+  if (result.count("help")) {
+    std::cout << options.help() << std::endl;
+    exit(0);
+  }
+
+  auto n_threads = result["t"].as<size_t>();
+  if (n_threads == 0)
+    n_threads = std::max(size_t(std::thread::hardware_concurrency()), 1UL);
+  const auto socket_path = result["s"].as<std::string>();
+  Server daemon(socket_path, n_threads, result["c"].as<size_t>());
+  server = &daemon;
+  std::signal(SIGINT, stop);
+  std::signal(SIGTERM, stop);
+  std::cout << "Listening on " << socket_path << " with " << n_threads
+            << " threads" << std::endl;
+  daemon.serve();
+  server = nullptr;
+  std::cout << "Loaded " << daemon.n_instance_loads() << " instances\n";
+  return 0;
+}
@@ -2,8 +2,12 @@
 // Created by Davide Nicoli on 18/05/22.
 //
 
+#define CATCH_CONFIG_RUNNER
 #include <catch2/catch.hpp>
 #include <sstream>
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
 
 int test_constant() { return 42; }
 
@@ -14,4 +18,16 @@ using namespace Catch::literals;
 TEST_CASE("Trying Catch2", "[catch2]") {
   SECTION("Assert call to constant") { REQUIRE(test_constant() == 42); }
   SECTION("Assert float product") { REQUIRE(test_product(3.0) == 6.0_a); }
-}
\ No newline at end of file
+}
+
+int main(int argc, char *argv[]) {
+#ifdef USE_MPI
+  // The runs of genetic::Process communicate through MPI_COMM_WORLD
+  MPI_Init(&argc, &argv);
+#endif
+  const auto result = Catch::Session().run(argc, argv);
+#ifdef USE_MPI
+  MPI_Finalize();
+#endif
+  return result;
+}
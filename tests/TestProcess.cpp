@@ -0,0 +1,488 @@
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <array>
+#include <random>
+#include <set>
+#include <thread>
+#include <valarray>
+#include <vector>
+
+#include "fitness_cache.hpp"
+#include "genetic_algorithms/tsp_ga.hpp"
+#include "genetic_process.hpp"
+#include "selection.hpp"
+
+using point = std::valarray<double>;
+
+// Cities at (i, i^2 mod modulus), small enough for the optimum to be found
+// within a few generations, or drawn uniformly in the unit square
+template <size_t N_CITIES>
+std::array<point, N_CITIES> parabola_cities(size_t modulus) {
+  std::array<point, N_CITIES> cities;
+  for (size_t i = 0; i < N_CITIES; i++) {
+    cities[i] = point{double(i), double(i * i % modulus)};
+  }
+  return cities;
+}
+template <size_t N_CITIES>
+std::array<point, N_CITIES> uniform_cities(std::mt19937::result_type seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> coordinate(0, 1);
+  std::array<point, N_CITIES> cities;
+  std::generate(cities.begin(), cities.end(), [&]() {
+    return point{coordinate(rng), coordinate(rng)};
+  });
+  return cities;
+}
+
+// Requires the fitness carried along with each individual to be the one a
+// fresh TSP evaluates
+template <size_t N_CITIES, typename PopulationIt, typename EvaluationsIt>
+void require_carried_fitness(const std::array<point, N_CITIES> &cities,
+                             PopulationIt first_individual, size_t N,
+                             EvaluationsIt first_evaluation) {
+  TSP<point, N_CITIES> reference(cities);
+  for (size_t i = 0; i < N; i++) {
+    REQUIRE(*snext(first_evaluation, i) ==
+            reference.evaluate(*snext(first_individual, i)));
+  }
+}
+
+TEST_CASE("Lazy re-evaluation", "[process]") {
+  constexpr size_t N_CITIES = 8;
+  constexpr size_t POPULATION_SIZE = 100;
+  constexpr size_t N_ITERATIONS = 50;
+  const auto cities = parabola_cities<N_CITIES>(5);
+  using Problem = TSP<point, N_CITIES>;
+  genetic::Process gp((Problem(cities)));
+
+  std::vector<Problem::Individual> population(POPULATION_SIZE);
+  std::vector<Problem::FitnessMeasure> evaluations(POPULATION_SIZE);
+  std::mt19937 rng(1);
+  gp.run(population.begin(), POPULATION_SIZE, evaluations.begin(),
+         N_ITERATIONS, 0.05, rng);
+
+  SECTION("Counters cover every generation") {
+    REQUIRE(gp.n_evaluations() + gp.n_skipped_evaluations() ==
+            POPULATION_SIZE * N_ITERATIONS);
+    REQUIRE(gp.n_skipped_evaluations() > 0);
+  }
+  SECTION("Carried fitness matches the individuals") {
+    require_carried_fitness(cities, population.cbegin(), POPULATION_SIZE,
+                            evaluations.cbegin());
+  }
+}
+
+TEST_CASE("Fitness cache", "[process]") {
+  genetic::FitnessCache<uint64_t, double> cache(4);
+  REQUIRE_FALSE(cache.find(3).has_value());
+  cache.insert(3, 0.5);
+  REQUIRE(cache.find(3) == 0.5);
+  // Same slot, evicts the previous entry
+  cache.insert(19, 0.25);
+  REQUIRE_FALSE(cache.find(3).has_value());
+  REQUIRE(cache.find(19) == 0.25);
+
+  // Children bred again on 8 cities are found in the cache
+  constexpr size_t N_CITIES = 8;
+  constexpr size_t POPULATION_SIZE = 100;
+  genetic::Process gp((TSP<point, N_CITIES>(parabola_cities<N_CITIES>(5))));
+  std::vector<TSP<point, N_CITIES>::Individual> population(POPULATION_SIZE);
+  std::vector<TSP<point, N_CITIES>::FitnessMeasure> evaluations(
+      POPULATION_SIZE);
+  std::mt19937 rng(1);
+  gp.run(population.begin(), POPULATION_SIZE, evaluations.begin(), 20, 0.05,
+         rng);
+  REQUIRE(gp.n_cache_hits() > 0);
+}
+
+TEST_CASE("Duplicate replacement", "[process]") {
+  constexpr size_t N_CITIES = 8;
+  constexpr size_t POPULATION_SIZE = 100;
+  const auto cities = parabola_cities<N_CITIES>(5);
+  using Problem = TSP<point, N_CITIES>;
+  genetic::Process gp((Problem(cities)));
+  gp.set_replace_duplicates(true);
+
+  std::vector<Problem::Individual> population(POPULATION_SIZE);
+  std::vector<Problem::FitnessMeasure> evaluations(POPULATION_SIZE);
+  std::mt19937 rng(1);
+  gp.run(population.begin(), POPULATION_SIZE, evaluations.begin(), 50, 0.05,
+         rng);
+
+  REQUIRE(gp.n_replaced_duplicates() > 0);
+  const std::set<Problem::Individual> unique(population.cbegin(),
+                                             population.cend());
+  REQUIRE(unique.size() == POPULATION_SIZE);
+}
+
+TEST_CASE("Steady-state mode", "[process]") {
+  constexpr size_t N_CITIES = 12;
+  constexpr size_t POPULATION_SIZE = 100;
+  const auto cities = parabola_cities<N_CITIES>(7);
+  using Problem = TSP<point, N_CITIES>;
+  genetic::Process gp((Problem(cities)));
+  gp.set_steady_state(true);
+
+  std::vector<Problem::Individual> population(POPULATION_SIZE);
+  std::vector<Problem::FitnessMeasure> evaluations(POPULATION_SIZE);
+  std::mt19937 rng(3);
+  gp.run(population.begin(), POPULATION_SIZE, evaluations.begin(), 0, 0.05,
+         rng);
+  const auto initial_best =
+      *std::max_element(evaluations.cbegin(), evaluations.cend());
+  gp.run(population.begin(), POPULATION_SIZE, evaluations.begin(), 100, 0.05,
+         rng);
+
+  REQUIRE(*std::max_element(evaluations.cbegin(), evaluations.cend()) >
+          initial_best);
+  // The best individual is published once per generation of
+  // POPULATION_SIZE / 2 steps
+  REQUIRE(gp.best()->generation == 100);
+}
+
+TEST_CASE("Adaptive mutation", "[process]") {
+  constexpr size_t N_CITIES = 12;
+  constexpr size_t POPULATION_SIZE = 100;
+  const auto cities = parabola_cities<N_CITIES>(7);
+  using Problem = TSP<point, N_CITIES>;
+  Problem tsp(cities);
+  tsp.set_adaptive_operators(true);
+  genetic::Process gp(std::move(tsp));
+  gp.set_adaptive_mutation(true);
+  gp.set_steady_state(GENERATE(false, true));
+  REQUIRE(gp.mutation_probability_factor() == Approx(1.55));
+
+  std::vector<Problem::Individual> population(POPULATION_SIZE);
+  std::vector<Problem::FitnessMeasure> evaluations(POPULATION_SIZE);
+  std::mt19937 rng(3);
+  gp.run(population.begin(), POPULATION_SIZE, evaluations.begin(), 100, 0.05,
+         rng);
+
+  // Both controls have moved away from their uniform start
+  REQUIRE(gp.mutation_probability_factor() != Approx(1.55));
+  REQUIRE(gp.ga().operator_probabilities()[0] != Approx(0.5));
+}
+
+TEST_CASE("Similar children rejection", "[process]") {
+  constexpr size_t N_CITIES = 12;
+  constexpr size_t POPULATION_SIZE = 100;
+  const auto cities = parabola_cities<N_CITIES>(7);
+  using Problem = TSP<point, N_CITIES>;
+  const auto steady_state = GENERATE(false, true);
+  std::vector<Problem::Individual> population(POPULATION_SIZE);
+  std::vector<Problem::FitnessMeasure> evaluations(POPULATION_SIZE);
+  Problem::EdgeTable edges;
+  std::array<double, 2> diversity{};
+  for (size_t k = 0; k < 2; k++) {
+    genetic::Process gp((Problem(cities)));
+    gp.set_steady_state(steady_state);
+    gp.set_max_similarity(k == 0 ? 1. : 0.3);
+    std::mt19937 rng(3);
+    gp.run(population.begin(), POPULATION_SIZE, evaluations.begin(), 100,
+           0.05, rng);
+    REQUIRE((gp.n_rejected_similar() > 0) == (k == 1));
+    edges.assign(population.cbegin(), POPULATION_SIZE);
+    diversity[k] = edges.diversity();
+  }
+  REQUIRE(diversity[1] > diversity[0]);
+}
+
+TEST_CASE("Selection policies", "[process]") {
+  const std::vector<double> evaluations{0.1, 0.4, 0.2, 0.8, 0.3};
+  const size_t N = evaluations.size();
+  std::mt19937 rng(5);
+  std::vector<size_t> counts(N);
+  const auto count = [&](auto &policy) {
+    std::fill(counts.begin(), counts.end(), 0);
+    std::vector<size_t> selected(N);
+    struct {
+    } no_ga;
+    for (auto i = 0; i < 2000; i++) {
+      policy.select(no_ga, evaluations.cbegin(), N, selected.begin(), rng);
+      for (const auto s : selected) {
+        REQUIRE(s < N);
+        counts[s]++;
+      }
+    }
+  };
+
+  SECTION("Tournament") {
+    genetic::selection::Tournament tournament(3);
+    count(tournament);
+    // The worst individual only wins tournaments against itself
+    REQUIRE(counts[0] < counts[2]);
+    REQUIRE(counts[2] < counts[4]);
+    REQUIRE(counts[4] < counts[1]);
+    REQUIRE(counts[1] < counts[3]);
+    REQUIRE(double(counts[0]) == Approx(2000. * 5 / 125).epsilon(0.3));
+  }
+  SECTION("Linear rank") {
+    genetic::selection::LinearRank rank(2.);
+    count(rank);
+    // Probabilities 0, 1/10, 2/10, 3/10, 4/10 from the worst
+    REQUIRE(counts[0] == 0);
+    REQUIRE(double(counts[2]) == Approx(1000).epsilon(0.1));
+    REQUIRE(double(counts[3]) == Approx(4000).epsilon(0.1));
+  }
+}
+
+TEST_CASE("Anytime best and cancellation", "[process]") {
+  constexpr size_t N_CITIES = 30;
+  constexpr size_t POPULATION_SIZE = 100;
+  constexpr size_t N_ITERATIONS = 1000000;
+  const auto cities = uniform_cities<N_CITIES>(3);
+  std::mt19937 rng(3);
+  using Problem = TSP<point, N_CITIES>;
+  for (const auto steady_state : {false, true}) {
+    genetic::Process gp((Problem(cities)));
+    gp.set_steady_state(steady_state);
+    genetic::CancellationToken token;
+    gp.set_cancellation(token);
+    REQUIRE_FALSE(gp.best());
+
+    std::vector<Problem::Individual> population(POPULATION_SIZE);
+    std::vector<Problem::FitnessMeasure> evaluations(POPULATION_SIZE);
+    std::thread solver([&]() {
+      gp.run(population.begin(), POPULATION_SIZE, evaluations.begin(),
+             N_ITERATIONS, 0.05, rng);
+    });
+    // The best individual is published every generation
+    decltype(gp.best()) first;
+    while (!(first = gp.best()) || first->generation < 2) {
+      std::this_thread::yield();
+    }
+    auto latest = gp.best();
+    while (latest->generation < first->generation + 10) {
+      latest = gp.best();
+    }
+    token.cancel();
+    solver.join();
+
+    REQUIRE(latest->fitness >= first->fitness);
+    const auto last = gp.best();
+    REQUIRE(last->fitness >=
+            *std::max_element(evaluations.cbegin(), evaluations.cend()));
+    Problem check(cities);
+    REQUIRE(check.evaluate(last->individual) == Approx(last->fitness));
+    REQUIRE(gp.n_evaluations() + gp.n_skipped_evaluations() <
+            POPULATION_SIZE * N_ITERATIONS);
+  }
+}
+
+TEST_CASE("Parallel mode", "[process]") {
+  constexpr size_t N_CITIES = 30;
+  constexpr size_t POPULATION_SIZE = 100;
+  constexpr size_t N_ITERATIONS = 50;
+  const auto cities = uniform_cities<N_CITIES>(11);
+  using Problem = TSP<point, N_CITIES>;
+  const auto solve = [&](size_t n_threads, bool replace_duplicates) {
+    genetic::Process gp((Problem(cities)));
+    gp.set_threads(n_threads);
+    gp.set_replace_duplicates(replace_duplicates);
+    REQUIRE(gp.n_threads() == n_threads);
+    auto population = gp.allocate<Problem::Individual>(POPULATION_SIZE);
+    auto evaluations = gp.allocate<Problem::FitnessMeasure>(POPULATION_SIZE);
+    std::mt19937 run_rng(5);
+    gp.run(population.begin(), POPULATION_SIZE, evaluations.begin(),
+           N_ITERATIONS, 0.05, run_rng);
+
+    // The counters of the workers are added up
+    REQUIRE(gp.n_evaluations() + gp.n_skipped_evaluations() ==
+            POPULATION_SIZE * N_ITERATIONS);
+    if (n_threads > 1) {
+      const auto stats = gp.worker_stats();
+      size_t n_chunks = 0;
+      for (const auto &worker : stats) {
+        n_chunks += worker.n_chunks;
+      }
+      // Chunks of 16 individuals for every evaluation and generation
+      REQUIRE(n_chunks >= (N_ITERATIONS + 1) * POPULATION_SIZE / 16);
+      for (const auto utilisation : gp.worker_utilisation()) {
+        REQUIRE(utilisation >= 0);
+        REQUIRE(utilisation <= 1);
+      }
+    }
+    return std::vector<Problem::Individual>(population.cbegin(),
+                                            population.cend());
+  };
+  solve(1, false);
+  for (const auto replace_duplicates : {false, true}) {
+    // Chunks draw from their own engines, so that the scheduling and the
+    // number of threads do not matter
+    const auto first = solve(3, replace_duplicates);
+    REQUIRE(solve(3, replace_duplicates) == first);
+    REQUIRE(solve(2, replace_duplicates) == first);
+  }
+}
+
+TEST_CASE("Parallel seeding", "[process]") {
+  constexpr size_t N_CITIES = 30;
+  constexpr size_t POPULATION_SIZE = 100;
+  const auto cities = uniform_cities<N_CITIES>(13);
+  using Problem = TSP<point, N_CITIES>;
+  const auto seed = [&](size_t n_threads, Problem::Seeding seeding) {
+    Problem tsp(cities);
+    tsp.set_seeding(seeding);
+    genetic::Process gp(std::move(tsp));
+    gp.set_threads(n_threads);
+    auto population = gp.allocate<Problem::Individual>(POPULATION_SIZE);
+    std::mt19937 run_rng(5);
+    gp.generate(population.begin(), POPULATION_SIZE, run_rng);
+    return std::vector<Problem::Individual>(population.cbegin(),
+                                            population.cend());
+  };
+  for (const auto seeding :
+       {Problem::Seeding::random, Problem::Seeding::nearest_neighbour,
+        Problem::Seeding::greedy}) {
+    const auto population = seed(3, seeding);
+    REQUIRE(seed(2, seeding) == population);
+    if (seeding == Problem::Seeding::greedy) {
+      // The first individual is the unperturbed greedy tour, and the first
+      // ones of the other chunks are perturbed
+      std::mt19937 unused(0);
+      std::vector<Problem::Individual> base(1);
+      Problem tsp(cities);
+      tsp.set_seeding(seeding);
+      tsp.generate(base.begin(), 1, unused);
+      REQUIRE(population[0] == base[0]);
+      size_t n_base = 0;
+      for (size_t i = 16; i < POPULATION_SIZE; i += 16) {
+        n_base += population[i] == base[0] ? 1 : 0;
+      }
+      REQUIRE(n_base < POPULATION_SIZE / 16);
+    }
+  }
+}
+
+TEST_CASE("Pipelined mode", "[process]") {
+  constexpr size_t N_CITIES = 30;
+  constexpr size_t POPULATION_SIZE = 100;
+  constexpr size_t N_ITERATIONS = 50;
+  const auto cities = uniform_cities<N_CITIES>(11);
+  std::mt19937 rng(11);
+  using Problem = TSP<point, N_CITIES>;
+  const auto solve = [&](size_t n_threads, size_t radius, bool cancelled) {
+    genetic::Process gp(Problem(cities), genetic::selection::Tournament(3));
+    gp.set_threads(n_threads);
+    gp.set_pipelined(true, radius);
+    genetic::CancellationToken token;
+    gp.set_cancellation(token);
+    if (cancelled)
+      token.cancel();
+    auto population = gp.allocate<Problem::Individual>(POPULATION_SIZE);
+    auto evaluations = gp.allocate<Problem::FitnessMeasure>(POPULATION_SIZE);
+    std::mt19937 run_rng(5);
+    gp.run(population.begin(), POPULATION_SIZE, evaluations.begin(),
+           N_ITERATIONS, 0.05, run_rng);
+
+    const auto best = gp.best();
+    REQUIRE(best);
+    REQUIRE(best->fitness >= *std::max_element(evaluations.cbegin(),
+                                               evaluations.cend()));
+    if (cancelled) {
+      REQUIRE(gp.n_evaluations() + gp.n_skipped_evaluations() == 0);
+      REQUIRE(best->generation == 0);
+    } else {
+      // Every chunk went through every generation
+      REQUIRE(gp.n_evaluations() + gp.n_skipped_evaluations() ==
+              POPULATION_SIZE * N_ITERATIONS);
+      REQUIRE(best->generation == N_ITERATIONS);
+    }
+    return std::vector<Problem::Individual>(population.cbegin(),
+                                            population.cend());
+  };
+  for (const auto radius : {1, 2}) {
+    // Whatever the order in which the chunks were bred
+    const auto first = solve(3, size_t(radius), false);
+    REQUIRE(solve(3, size_t(radius), false) == first);
+    REQUIRE(solve(2, size_t(radius), false) == first);
+  }
+  solve(2, 1, true);
+
+  // Options that pipelined runs do not apply are refused
+  std::vector<Problem::Individual> population(POPULATION_SIZE);
+  std::vector<Problem::FitnessMeasure> evaluations(POPULATION_SIZE);
+  for (size_t option = 0; option < 3; option++) {
+    genetic::Process gp((Problem(cities)));
+    gp.set_threads(2);
+    gp.set_pipelined(true);
+    gp.set_adaptive_mutation(option == 0);
+    gp.set_max_similarity(option == 1 ? 0.5 : 1.);
+    gp.set_replace_duplicates(option == 2);
+    REQUIRE_THROWS(gp.run(population.begin(), POPULATION_SIZE,
+                          evaluations.begin(), N_ITERATIONS, 0.05, rng));
+    REQUIRE_THROWS(gp.mpi_run(population.begin(), POPULATION_SIZE,
+                              evaluations.begin(), 1, 1, 0.05, rng));
+  }
+}
+
+TEST_CASE("Gap-based stop", "[process]") {
+  constexpr size_t N_CITIES = 8;
+  constexpr size_t POPULATION_SIZE = 100;
+  constexpr size_t ITERATIONS_PER_BLOCK = 5;
+  const auto cities = parabola_cities<N_CITIES>(5);
+  using Problem = TSP<point, N_CITIES>;
+  Problem tsp(cities);
+  const auto lower_bound = tsp.lower_bound();
+  genetic::Process gp(std::move(tsp));
+  // Any path of the first block is within 1000% of the bound
+  gp.set_stop_gap(Problem::fitness_of(lower_bound), 10.);
+
+  std::vector<Problem::Individual> population(POPULATION_SIZE);
+  std::vector<Problem::FitnessMeasure> evaluations(POPULATION_SIZE);
+  std::mt19937 rng(1);
+  gp.mpi_run(population.begin(), POPULATION_SIZE, evaluations.begin(),
+             ITERATIONS_PER_BLOCK, 100, 0.05, rng);
+
+  REQUIRE(gp.n_evaluations() + gp.n_skipped_evaluations() ==
+          POPULATION_SIZE * ITERATIONS_PER_BLOCK);
+  REQUIRE(gp.gap() >= 0.);
+  REQUIRE(gp.gap() <= 10.);
+
+  // The gap is also measured when the last block ends the run, here against
+  // a bound that no path can get within 100% of
+  genetic::Process single_block(Problem{cities});
+  single_block.set_stop_gap(Problem::fitness_of(lower_bound / 2), 0.);
+  single_block.mpi_run(population.begin(), POPULATION_SIZE,
+                       evaluations.begin(), ITERATIONS_PER_BLOCK, 1, 0.05, rng);
+  REQUIRE(single_block.gap() >= 1.);
+}
+
+TEST_CASE("Stagnation", "[process]") {
+  constexpr size_t N_CITIES = 8;
+  constexpr size_t POPULATION_SIZE = 100;
+  constexpr size_t N_BLOCKS = 50;
+  const auto cities = parabola_cities<N_CITIES>(5);
+  using Problem = TSP<point, N_CITIES>;
+  genetic::Process gp((Problem(cities)));
+  using Stagnation = decltype(gp)::Stagnation;
+  std::vector<Problem::Individual> population(POPULATION_SIZE);
+  std::vector<Problem::FitnessMeasure> evaluations(POPULATION_SIZE);
+  std::mt19937 rng(1);
+
+  SECTION("Stop") {
+    // The optimum of 8 cities is found long before the last block
+    gp.set_stagnation(3, Stagnation::stop);
+    gp.mpi_run(population.begin(), POPULATION_SIZE, evaluations.begin(), 5,
+               N_BLOCKS, 0.05, rng);
+    const auto &history = gp.history();
+    REQUIRE(history.size() < N_BLOCKS);
+    for (size_t i = 1; i < history.size(); i++) {
+      REQUIRE(history[i].best >= history[i - 1].best);
+      REQUIRE(history[i].mean <= double(history[i].best));
+    }
+    REQUIRE(history.back().best == history[history.size() - 4].best);
+  }
+  SECTION("Restart") {
+    gp.set_stagnation(1, Stagnation::restart, 0.2);
+    gp.set_steady_state(GENERATE(false, true));
+    gp.mpi_run(population.begin(), POPULATION_SIZE, evaluations.begin(), 5,
+               N_BLOCKS, 0.05, rng);
+    REQUIRE(gp.history().size() == N_BLOCKS);
+    REQUIRE(gp.n_restarts() > 0);
+    // The restarted individuals were evaluated again
+    require_carried_fitness(cities, population.cbegin(), POPULATION_SIZE,
+                            evaluations.cbegin());
+  }
+}
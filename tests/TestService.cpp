@@ -0,0 +1,142 @@
+#include <catch2/catch.hpp>
+#include <array>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+
+#include "genetic_algorithms/buckets.hpp"
+#include "genetic_algorithms/metrics.hpp"
+#include "genetic_algorithms/service.hpp"
+
+using namespace Catch::literals;
+
+TEST_CASE("Frame encoding", "[service]") {
+  const service::Request request{"cities.tsp", 7, 20, 30, 0.25, "rank"};
+  const auto decoded = service::decode_request(service::encode(request));
+  REQUIRE(decoded.instance == "cities.tsp");
+  REQUIRE(decoded.seed == 7);
+  REQUIRE(decoded.population_size == 20);
+  REQUIRE(decoded.n_iterations == 30);
+  REQUIRE(decoded.mutation_probability == 0.25_a);
+  REQUIRE(decoded.selection == "rank");
+
+  service::Response response;
+  response.length = 12.5;
+  response.n_evaluations = 3;
+  response.path = {3, 1, 2};
+  const auto payload = service::encode(response);
+  const auto round_trip = service::decode_response(payload);
+  REQUIRE(round_trip.error.empty());
+  REQUIRE(round_trip.length == 12.5_a);
+  REQUIRE(round_trip.path == response.path);
+  REQUIRE_THROWS(service::decode_response(payload.substr(0, 10)));
+}
+
+TEST_CASE("Solver service", "[service]") {
+  // Cities on a line, so that the shortest path from city 0 visits them in
+  // order. They are padded to the bucket of 8, and the larger instance is
+  // solved by decomposition.
+  using Server = service::Server<metrics::Euclidean, buckets::Sizes<8>>;
+  // A directory of its own, so that concurrent runs do not share the socket
+  auto pattern =
+      (std::filesystem::temp_directory_path() / "genetic_tsp_XXXXXX").string();
+  REQUIRE(::mkdtemp(pattern.data()) != nullptr);
+  const std::filesystem::path directory(pattern);
+  struct Cleanup {
+    std::filesystem::path directory;
+    ~Cleanup() { std::filesystem::remove_all(directory); }
+  } cleanup{directory};
+  const auto socket_path = (directory / "test.sock").string();
+  const auto instance_path = (directory / "test.tsp").string();
+  std::ofstream(instance_path)
+      << "NAME: line\nTYPE: TSP\nDIMENSION: 6\nEDGE_WEIGHT_TYPE: EUC_2D\n"
+         "NODE_COORD_SECTION\n1 0 0\n2 30 0\n3 10 0\n4 50 0\n5 20 0\n"
+         "6 40 0\nEOF\n";
+  const auto large_path = (directory / "test_large.tsp").string();
+  {
+    std::ofstream large(large_path);
+    large << "NAME: line\nTYPE: TSP\nDIMENSION: 12\nEDGE_WEIGHT_TYPE: "
+             "EUC_2D\nNODE_COORD_SECTION\n";
+    for (size_t i = 0; i < 12; i++) {
+      large << i + 1 << ' ' << 10 * ((5 * i) % 12) << " 0\n";
+    }
+    large << "EOF\n";
+  }
+
+  Server server(socket_path, 2, 4, std::chrono::milliseconds(200));
+  // Stops the server even when a requirement fails
+  struct Serving {
+    Server &server;
+    std::thread thread;
+    ~Serving() {
+      server.stop();
+      thread.join();
+    }
+  } serving{server, std::thread([&]() { server.serve(); })};
+
+  service::Request request{instance_path, 1, 100, 100, 0.1, "tournament"};
+  {
+    const auto connection = service::connect(socket_path);
+    auto response = service::call(connection, request);
+    REQUIRE(response.error.empty());
+    REQUIRE(response.length == 50.0_a);
+    REQUIRE(response.path == std::vector<uint32_t>{2, 4, 1, 5, 3});
+
+    // The instance stays loaded across requests and connections
+    request.seed = 2;
+    response = service::call(connection, request);
+    REQUIRE(response.error.empty());
+    REQUIRE(response.length == 50.0_a);
+
+    request.selection = "unknown";
+    response = service::call(connection, request);
+    REQUIRE_FALSE(response.error.empty());
+  }
+  {
+    const auto connection = service::connect(socket_path);
+    request.selection = "roulette";
+    REQUIRE(service::call(connection, request).error.empty());
+    request.instance = large_path;
+    const auto response = service::call(connection, request);
+    REQUIRE(response.error.empty());
+    REQUIRE(response.path.size() == 11);
+    REQUIRE(response.length >= 110.0_a);
+    request.instance = (directory / "missing.tsp").string();
+    REQUIRE_FALSE(service::call(connection, request).error.empty());
+  }
+  {
+    // More clients than workers take turns on connections they keep open
+    std::vector<service::Socket> connections;
+    for (size_t k = 0; k < 3; k++) {
+      connections.push_back(service::connect(socket_path));
+    }
+    const service::Request turn{instance_path, 3, 20, 20, 0.1, "rank"};
+    for (size_t round = 0; round < 2; round++) {
+      for (const auto &connection : connections) {
+        REQUIRE(service::call(connection, turn).error.empty());
+      }
+    }
+  }
+  {
+    // Clients stalling within a frame hold the workers only until the
+    // timeout
+    std::vector<service::Socket> stalled;
+    for (size_t k = 0; k < 2; k++) {
+      stalled.push_back(service::connect(socket_path));
+      const uint16_t partial_size = 7;
+      REQUIRE(::send(stalled.back().fd(), &partial_size, sizeof(partial_size),
+                     0) == sizeof(partial_size));
+    }
+    // Until both are taken by the workers
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto connection = service::connect(socket_path);
+    const service::Request after{instance_path, 4, 20, 20, 0.1, "rank"};
+    REQUIRE(service::call(connection, after).error.empty());
+  }
+  REQUIRE(server.n_instance_loads() == 2);
+}
@@ -0,0 +1,652 @@
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <unistd.h>
+#include <valarray>
+
+#include "genetic_algorithms/buckets.hpp"
+#include "genetic_algorithms/decomposition.hpp"
+#include "genetic_algorithms/edge_frequency.hpp"
+#include "genetic_algorithms/instance.hpp"
+#include "genetic_algorithms/metrics.hpp"
+#include "genetic_algorithms/renumbering.hpp"
+#include "genetic_algorithms/tsp_ga.hpp"
+#include "genetic_algorithms/two_level_list.hpp"
+#include "genetic_algorithms/warm_start.hpp"
+
+using namespace Catch::literals;
+using point = std::valarray<double>;
+
+TEST_CASE("Distance metrics", "[tsp]") {
+  const point a{0, 0}, b{3, 4};
+  SECTION("L1") { REQUIRE(metrics::L1::distance(a, b) == 7.0_a); }
+  SECTION("Euclidean") { REQUIRE(metrics::Euclidean::distance(a, b) == 5.0_a); }
+  SECTION("Rounded euclidean") {
+    REQUIRE(metrics::RoundedEuclidean::distance(a, point{1, 1}) == 1.0_a);
+    // Halves are rounded up, as by TSPLIB, not to even
+    REQUIRE(metrics::RoundedEuclidean::distance(a, point{0, 2.5}) == 3.0_a);
+    REQUIRE(metrics::RoundedEuclidean::distance(a, point{0, 0.5}) == 1.0_a);
+  }
+  SECTION("ATT") {
+    // sqrt(25 / 10) = 1.58 is rounded up to 2
+    REQUIRE(metrics::ATT::distance(a, b) == 2.0_a);
+    REQUIRE(metrics::ATT::distance(a, point{10, 0}) == 4.0_a);
+  }
+  SECTION("Great circle") {
+    // A quarter of the equator
+    REQUIRE(metrics::GreatCircle::distance(a, point{90, 0}) ==
+            Approx(M_PI / 2 * metrics::GreatCircle::earth_radius));
+    REQUIRE(metrics::GreatCircle::distance(point{10, 90}, point{70, 90}) ==
+            Approx(0).margin(1e-6));
+  }
+}
+
+TEST_CASE("TSP evaluation", "[tsp]") {
+  // Paths start from city 0 and are not closed
+  const std::array<point, 4> square{point{0, 0}, point{2, 0}, point{2, 2},
+                                    point{0, 2}};
+  SECTION("L1") {
+    TSP<point, 4> tsp(square);
+    REQUIRE(tsp.evaluate({1, 2, 3}) == Approx(1. / 6));
+    REQUIRE(tsp.evaluate({2, 1, 3}) == Approx(1. / 10));
+  }
+  SECTION("Euclidean") {
+    TSP<point, 4, metrics::Euclidean> tsp(square);
+    REQUIRE(tsp.evaluate({1, 2, 3}) == Approx(1. / 6));
+    REQUIRE(tsp.evaluate({2, 1, 3}) == Approx(1. / (2 + 2 * std::sqrt(8.))));
+  }
+}
+
+TEST_CASE("TSP distance storage", "[tsp]") {
+  constexpr size_t N = 200;
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> coordinate(0, 1000);
+  std::array<point, N> cities;
+  std::generate(cities.begin(), cities.end(), [&]() {
+    return point{coordinate(rng), coordinate(rng)};
+  });
+
+  using Reference = TSP<point, N, metrics::Euclidean>;
+  using Single = TSP<point, N, metrics::Euclidean, float>;
+  using Fixed = TSP<point, N, metrics::Euclidean, uint32_t>;
+  Reference reference(cities);
+  Single single(cities);
+  Fixed fixed(cities);
+  // Copies share the table of the original
+  Fixed copy(fixed);
+
+  std::vector<Reference::Individual> population(100);
+  reference.generate(population.begin(), population.size(), rng);
+  for (const auto &individual : population) {
+    const auto exact = reference.length(individual);
+    REQUIRE(copy.evaluate(individual) == fixed.evaluate(individual));
+    REQUIRE(single.length(individual) == Approx(exact).epsilon(1e-5));
+    REQUIRE(fixed.length(individual) == Approx(exact).epsilon(1e-6));
+    REQUIRE(single.evaluate(individual) ==
+            Approx(reference.evaluate(individual)).epsilon(1e-5));
+    REQUIRE(fixed.evaluate(individual) ==
+            Approx(reference.evaluate(individual)).epsilon(1e-5));
+  }
+}
+
+TEST_CASE("TSP edge hashing", "[tsp]") {
+  constexpr size_t N = 30;
+  std::array<point, N> cities;
+  for (size_t i = 0; i < N; i++) {
+    cities[i] = point{double(i), 0};
+  }
+  using Problem = TSP<point, N>;
+  Problem tsp(cities);
+  std::mt19937 rng(7);
+  std::vector<Problem::Individual> population(2);
+  tsp.generate(population.begin(), population.size(), rng);
+
+  SECTION("Mutations update the hash") {
+    auto individual = population[0];
+    auto hash = tsp.hash(individual);
+    for (auto i = 0; i < 1000; i++) {
+      tsp.mutate(individual, hash, rng);
+      REQUIRE(hash == tsp.hash(individual));
+    }
+  }
+  SECTION("Crossover updates the hashes") {
+    for (auto i = 0; i < 1000; i++) {
+      auto hash_1 = tsp.hash(population[0]);
+      auto hash_2 = tsp.hash(population[1]);
+      Problem::Individual child_1;
+      Problem::Individual child_2;
+      tsp.crossover(population[0], population[1], child_1, child_2, hash_1,
+                    hash_2, rng);
+      REQUIRE(hash_1 == tsp.hash(child_1));
+      REQUIRE(hash_2 == tsp.hash(child_2));
+      population[0] = child_1;
+      population[1] = child_2;
+    }
+  }
+  SECTION("Crossover swaps the order of the tails by rank") {
+    for (auto i = 0; i < 1000; i++) {
+      // The cut crossover draws
+      auto cut_rng = rng;
+      const auto cut = std::uniform_int_distribution<size_t>(0, N - 2)(cut_rng);
+      auto expected_1 = population[0];
+      auto expected_2 = population[1];
+      swap_order_by_rank(snext(expected_1.begin(), cut), expected_1.end(),
+                         snext(expected_2.begin(), cut));
+      Problem::Individual child_1;
+      Problem::Individual child_2;
+      tsp.crossover(population[0], population[1], child_1, child_2, rng);
+      REQUIRE(child_1 == expected_1);
+      REQUIRE(child_2 == expected_2);
+      population[0] = child_1;
+      population[1] = child_2;
+    }
+  }
+  SECTION("Different paths have different hashes") {
+    auto individual = population[0];
+    std::swap(individual[3], individual[10]);
+    REQUIRE(tsp.hash(individual) != tsp.hash(population[0]));
+  }
+}
+
+TEST_CASE("TSP adaptive operators", "[tsp]") {
+  constexpr size_t N = 30;
+  std::mt19937 rng(31);
+  std::uniform_real_distribution<double> coordinate(0, 1);
+  std::array<point, N> cities;
+  std::generate(cities.begin(), cities.end(), [&]() {
+    return point{coordinate(rng), coordinate(rng)};
+  });
+  using Problem = TSP<point, N, metrics::Euclidean>;
+  Problem tsp(cities);
+  tsp.set_adaptive_operators(true);
+  std::vector<Problem::Individual> population(1);
+  tsp.generate(population.begin(), 1, rng);
+  auto &individual = population[0];
+  auto hash = tsp.hash(individual);
+  for (size_t i = 0; i < 1000; i++) {
+    tsp.mutate(individual, hash, rng);
+    REQUIRE(hash == tsp.hash(individual));
+  }
+  const auto &probabilities = tsp.operator_probabilities();
+  REQUIRE(probabilities[0] + probabilities[1] == Approx(1.));
+  REQUIRE(std::min(probabilities[0], probabilities[1]) >= 0.05 - 1e-12);
+}
+
+TEST_CASE("Edge frequency", "[tsp]") {
+  constexpr size_t N = 20;
+  std::mt19937 rng(37);
+  std::vector<std::array<unsigned short, N - 1>> population(30);
+  for (auto &individual : population) {
+    std::iota(individual.begin(), individual.end(), 1);
+    std::shuffle(individual.begin(), individual.end(), rng);
+  }
+  EdgeFrequency<N> edges;
+
+  SECTION("Identical paths") {
+    edges.assign(std::vector(10, population[0]).cbegin(), 10);
+    REQUIRE(edges.diversity() == Approx(0).margin(1e-12));
+    REQUIRE(edges.similarity(population[0]) == 1.0_a);
+  }
+  SECTION("Incremental updates") {
+    edges.assign(population.cbegin(), population.size());
+    const auto diversity = edges.diversity();
+    REQUIRE(diversity > 0.5);
+    REQUIRE(diversity <= 1.);
+    const auto similarity = edges.similarity(population[3]);
+    REQUIRE(similarity > 0.);
+    edges.remove(population[3]);
+    REQUIRE(edges.size() == population.size() - 1);
+    REQUIRE(edges.similarity(population[3]) < similarity);
+    edges.add(population[3]);
+    REQUIRE(edges.diversity() == Approx(diversity));
+    REQUIRE(edges.similarity(population[3]) == Approx(similarity));
+  }
+}
+
+TEST_CASE("TSP seeding", "[tsp]") {
+  constexpr size_t N = 40;
+  std::array<point, N> circle;
+  for (size_t i = 0; i < N; i++) {
+    circle[i] = point{std::cos(2 * double(i) * M_PI / double(N)),
+                      std::sin(2 * double(i) * M_PI / double(N))};
+  }
+  using Problem = TSP<point, N, metrics::Euclidean>;
+  const auto chord = 2 * std::sin(M_PI / double(N));
+  std::mt19937 rng(11);
+  std::vector<Problem::Individual> population(20);
+
+  for (const auto seeding :
+       {Problem::Seeding::random, Problem::Seeding::nearest_neighbour,
+        Problem::Seeding::greedy, Problem::Seeding::hilbert}) {
+    Problem tsp(circle);
+    tsp.set_seeding(seeding);
+    tsp.generate(population.begin(), population.size(), rng);
+    for (auto individual : population) {
+      std::sort(individual.begin(), individual.end());
+      for (size_t i = 0; i < N - 1; i++) {
+        REQUIRE(individual[i] == i + 1);
+      }
+    }
+    // Following the circle is optimal
+    const auto optimum = double(N - 1) * chord;
+    if (seeding == Problem::Seeding::nearest_neighbour ||
+        seeding == Problem::Seeding::greedy) {
+      REQUIRE(tsp.length(population[0]) == Approx(optimum).epsilon(1e-6));
+    } else if (seeding == Problem::Seeding::hilbert) {
+      REQUIRE(tsp.length(population[0]) < 2 * optimum);
+    }
+  }
+}
+
+TEST_CASE("Warm start", "[tsp]") {
+  constexpr size_t N = 40;
+  std::array<point, N> circle;
+  for (size_t i = 0; i < N; i++) {
+    circle[i] = point{std::cos(2 * double(i) * M_PI / double(N)),
+                      std::sin(2 * double(i) * M_PI / double(N))};
+  }
+  const auto optimum = double(N - 1) * 2 * std::sin(M_PI / double(N));
+  // The previous instance lacked city 7 and had an extra city at the centre,
+  // and its cities were listed in reverse order
+  std::array<point, N> previous_circle;
+  previous_circle[0] = circle[0];
+  previous_circle[1] = point{0, 0};
+  for (size_t i = 1, k = N - 1; i < N; i++) {
+    if (i != 7)
+      previous_circle[k--] = circle[i];
+  }
+  std::vector<size_t> previous_tour{0};
+  for (size_t k = N - 1; k > 1; k--) {
+    previous_tour.push_back(k);
+  }
+  previous_tour.push_back(1);
+
+  const auto new_to_old =
+      warm_start::match(previous_circle.cbegin(), N, circle.cbegin(), N);
+  REQUIRE(new_to_old[0] == 0);
+  REQUIRE(new_to_old[1] == N - 1);
+  REQUIRE(new_to_old[7] == warm_start::none);
+  REQUIRE(new_to_old[8] == N - 7);
+  const auto carried = warm_start::carry_over(previous_tour, new_to_old);
+  REQUIRE(carried.size() == N - 1);
+  REQUIRE(std::find(carried.cbegin(), carried.cend(), 7) == carried.cend());
+  REQUIRE(std::is_sorted(carried.cbegin(), carried.cend()));
+
+  using Problem = TSP<point, N, metrics::Euclidean>;
+  const Problem previous(previous_circle);
+  const std::vector<point> cities(circle.cbegin(), circle.cend());
+  Problem tsp(cities, previous, new_to_old);
+  Problem cold(circle);
+  // The rounded distances of a fixed-point table are not copied
+  const TSP<point, N, metrics::Euclidean, uint32_t> fixed_previous(
+      previous_circle);
+  const Problem from_fixed(cities, fixed_previous, new_to_old);
+  std::mt19937 rng(5);
+  std::vector<Problem::Individual> population(20);
+  cold.generate(population.begin(), population.size(), rng);
+  for (const auto &individual : population) {
+    REQUIRE(tsp.length(individual) == Approx(cold.length(individual)));
+    REQUIRE(from_fixed.length(individual) == cold.length(individual));
+  }
+
+  // City 7 is inserted back between 6 and 8
+  tsp.set_warm_start(carried);
+  tsp.generate(population.begin(), population.size(), rng);
+  REQUIRE(tsp.length(population[0]) == Approx(optimum));
+  for (auto individual : population) {
+    std::sort(individual.begin(), individual.end());
+    for (size_t i = 0; i < N - 1; i++) {
+      REQUIRE(individual[i] == i + 1);
+    }
+  }
+}
+
+TEST_CASE("Hilbert renumbering", "[tsp]") {
+  constexpr size_t N = 100;
+  std::mt19937 rng(13);
+  std::uniform_real_distribution<double> coordinate(0, 1);
+  std::array<point, N> cities, renumbered;
+  std::generate(cities.begin(), cities.end(), [&]() {
+    return point{coordinate(rng), coordinate(rng)};
+  });
+  const auto new_to_old = renumbering::hilbert(cities.cbegin(), N);
+  REQUIRE(new_to_old[0] == 0);
+  renumbering::apply(cities.cbegin(), new_to_old, renumbered.begin());
+
+  using Problem = TSP<point, N, metrics::Euclidean>;
+  Problem original_tsp(cities), renumbered_tsp(renumbered);
+  std::vector<Problem::Individual> population(10);
+  original_tsp.generate(population.begin(), population.size(), rng);
+  for (const auto &individual : population) {
+    auto mapped = individual;
+    renumbering::renumber(mapped.begin(), mapped.end(), new_to_old);
+    REQUIRE(renumbered_tsp.length(mapped) ==
+            Approx(original_tsp.length(individual)));
+    renumbering::restore(mapped.begin(), mapped.end(), new_to_old);
+    REQUIRE(mapped == individual);
+  }
+}
+
+TEST_CASE("Two-level list tour", "[tsp]") {
+  std::mt19937 rng(17);
+  for (const size_t N : {3UL, 17UL, 257UL}) {
+    std::vector<size_t> tour(N);
+    std::iota(tour.begin(), tour.end(), 0);
+    std::shuffle(tour.begin(), tour.end(), rng);
+    TwoLevelList list;
+    list.assign(tour.cbegin(), tour.cend());
+    std::uniform_int_distribution<size_t> city(0, N - 1);
+    for (size_t k = 0; k < 500; k++) {
+      const auto a = city(rng), b = city(rng);
+      // Reference: rotate a to the front and reverse up to b
+      std::rotate(tour.begin(), std::find(tour.begin(), tour.end(), a),
+                  tour.end());
+      std::reverse(tour.begin(),
+                   std::next(std::find(tour.begin(), tour.end(), b)));
+      list.reverse(a, b);
+
+      std::vector<size_t> written;
+      list.write(tour[0], std::back_inserter(written));
+      REQUIRE(written == tour);
+      for (size_t i = 0; i < N; i++) {
+        REQUIRE(list.next(tour[i]) == tour[(i + 1) % N]);
+        REQUIRE(list.prev(tour[(i + 1) % N]) == tour[i]);
+      }
+      const auto x = city(rng), y = city(rng), z = city(rng);
+      const auto position = [&](const size_t c) {
+        const auto p = std::find(tour.cbegin(), tour.cend(), c);
+        return (size_t(std::distance(tour.cbegin(), p)) + N -
+                size_t(std::distance(
+                    tour.cbegin(), std::find(tour.cbegin(), tour.cend(), x)))) %
+               N;
+      };
+      REQUIRE(list.between(x, y, z) == (position(y) <= position(z)));
+    }
+  }
+}
+
+TEST_CASE("TSP 2-opt local search", "[tsp]") {
+  constexpr size_t N = 60;
+  std::array<point, N> circle;
+  for (size_t i = 0; i < N; i++) {
+    circle[i] = point{std::cos(2 * double(i) * M_PI / double(N)),
+                      std::sin(2 * double(i) * M_PI / double(N))};
+  }
+  using Problem = TSP<point, N, metrics::Euclidean>;
+  Problem tsp(circle);
+  std::mt19937 rng(19);
+  std::vector<Problem::Individual> population(5);
+  tsp.generate(population.begin(), population.size(), rng);
+  for (auto &individual : population) {
+    const auto before = tsp.length(individual);
+    REQUIRE(tsp.two_opt(individual, 20000, rng) > 0);
+    REQUIRE(tsp.length(individual) < before);
+    // Still a path from city 0 through every other city
+    auto sorted = individual;
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t i = 0; i < N - 1; i++) {
+      REQUIRE(sorted[i] == i + 1);
+    }
+    // A random 2-opt local optimum on a circle is close to the optimum
+    REQUIRE(tsp.length(individual) <
+            1.5 * double(N - 1) * 2 * std::sin(M_PI / double(N)));
+  }
+
+  SECTION("Mutation keeps the hash consistent") {
+    tsp.set_local_search(100);
+    for (auto &individual : population) {
+      auto hash = tsp.hash(individual);
+      tsp.mutate(individual, hash, rng);
+      REQUIRE(hash == tsp.hash(individual));
+    }
+  }
+}
+
+TEST_CASE("Decomposition", "[tsp]") {
+  constexpr size_t N = 250;
+  constexpr size_t CLUSTER_SIZE = 40;
+  std::mt19937 rng(23);
+  std::uniform_real_distribution<double> coordinate(0, 1);
+  std::vector<point> cities(N);
+  std::generate(cities.begin(), cities.end(), [&]() {
+    return point{coordinate(rng), coordinate(rng)};
+  });
+  const auto distance = [&](const size_t x, const size_t y) {
+    return metrics::Euclidean::distance(cities[x], cities[y]);
+  };
+  const auto length = [&](const std::vector<size_t> &path) {
+    double total = 0;
+    for (size_t i = 1; i < path.size(); i++) {
+      total += distance(path[i - 1], path[i]);
+    }
+    return total;
+  };
+
+  const auto clusters =
+      decomposition::partition(cities.cbegin(), N, CLUSTER_SIZE);
+  REQUIRE(clusters.size() == 7);
+  REQUIRE(clusters[0][0] == 0);
+  REQUIRE(clusters.back().size() == N % CLUSTER_SIZE);
+
+  std::vector<std::vector<size_t>> paths;
+  std::vector<size_t> joints;
+  for (const auto &cluster : clusters) {
+    if (!paths.empty())
+      joints.push_back(joints.empty() ? CLUSTER_SIZE
+                                      : joints.back() + CLUSTER_SIZE);
+    paths.push_back(
+        decomposition::solve_cluster<CLUSTER_SIZE, metrics::Euclidean>(
+            cities.cbegin(), cluster, 50, 20, 0.05, rng));
+    // The padding is dropped
+    REQUIRE(paths.back().front() == cluster.front());
+    auto sorted = paths.back(), expected = cluster;
+    std::sort(sorted.begin(), sorted.end());
+    std::sort(expected.begin(), expected.end());
+    REQUIRE(sorted == expected);
+  }
+
+  auto path = decomposition::stitch(paths, distance);
+  REQUIRE(path.front() == 0);
+  const auto stitched = length(path);
+  decomposition::repair(path, joints, 10, distance);
+  REQUIRE(length(path) <= stitched);
+  REQUIRE(path.front() == 0);
+  std::sort(path.begin(), path.end());
+  for (size_t i = 0; i < N; i++) {
+    REQUIRE(path[i] == i);
+  }
+}
+
+TEST_CASE("Held-Karp lower bound", "[tsp]") {
+  SECTION("Below the optimum of a random instance") {
+    constexpr size_t N = 8;
+    std::mt19937 rng(29);
+    std::uniform_real_distribution<double> coordinate(0, 1);
+    std::array<point, N> cities;
+    std::generate(cities.begin(), cities.end(), [&]() {
+      return point{coordinate(rng), coordinate(rng)};
+    });
+    using Problem = TSP<point, N, metrics::Euclidean>;
+    Problem tsp(cities);
+    Problem::Individual individual;
+    std::iota(individual.begin(), individual.end(), 1);
+    auto optimum = tsp.length(individual);
+    while (std::next_permutation(individual.begin(), individual.end())) {
+      optimum = std::min(optimum, tsp.length(individual));
+    }
+    const auto bound = tsp.lower_bound();
+    REQUIRE(bound <= optimum + 1e-9);
+    REQUIRE(bound > 0.8 * optimum);
+  }
+  SECTION("Tight on a circle") {
+    constexpr size_t N = 30;
+    std::array<point, N> circle;
+    for (size_t i = 0; i < N; i++) {
+      circle[i] = point{std::cos(2 * double(i) * M_PI / double(N)),
+                        std::sin(2 * double(i) * M_PI / double(N))};
+    }
+    TSP<point, N, metrics::Euclidean> tsp(circle);
+    const auto optimum = double(N - 1) * 2 * std::sin(M_PI / double(N));
+    REQUIRE(tsp.lower_bound() <= optimum + 1e-9);
+    REQUIRE(tsp.lower_bound() == Approx(optimum).epsilon(0.01));
+  }
+}
+
+TEST_CASE("Instance loading", "[tsp]") {
+  // A file of its own, so that concurrent runs do not overwrite each other
+  auto path = (std::filesystem::temp_directory_path() / "genetic_tsp_XXXXXX")
+                  .string();
+  const auto fd = ::mkstemp(path.data());
+  REQUIRE(fd >= 0);
+  ::close(fd);
+  struct Cleanup {
+    const std::string &path;
+    ~Cleanup() { std::filesystem::remove(path); }
+  } cleanup{path};
+  const auto write = [&](const char *text) { std::ofstream(path) << text; };
+
+  SECTION("TSPLIB coordinates") {
+    write("NAME : square\nTYPE : TSP\nCOMMENT : four cities\n"
+          "DIMENSION : 4\nEDGE_WEIGHT_TYPE : EUC_2D\nNODE_COORD_SECTION\n"
+          "1 0 0\n2 3 0\n4 0 4\n3 3 4\nEOF\n");
+    const auto instance = instance::load_tsplib(path);
+    REQUIRE(instance.name == "square");
+    REQUIRE(instance.size() == 4);
+    REQUIRE(instance.coordinates[2] == std::array<double, 2>{3, 4});
+    const auto d = instance.distances();
+    REQUIRE(d[0 * 4 + 1] == 3.0_a);
+    REQUIRE(d[0 * 4 + 2] == 5.0_a);
+    REQUIRE(d[2 * 4 + 0] == 5.0_a);
+    REQUIRE(d[3 * 4 + 3] == 0.0_a);
+  }
+  SECTION("TSPLIB explicit weights") {
+    write("NAME: line\nTYPE: TSP\nDIMENSION: 4\n"
+          "EDGE_WEIGHT_TYPE: EXPLICIT\nEDGE_WEIGHT_FORMAT: UPPER_ROW\n"
+          "EDGE_WEIGHT_SECTION\n1 5 9\n2 6\n3\nEOF\n");
+    const auto instance = instance::load_tsplib(path);
+    REQUIRE(instance.size() == 4);
+    const auto d = instance.distances();
+    REQUIRE(d == std::vector<double>{0, 1, 5, 9, 1, 0, 2, 6,
+                                     5, 2, 0, 3, 9, 6, 3, 0});
+    // The coordinates only matter for seeding
+    std::array<point, 4> cities;
+    std::fill(cities.begin(), cities.end(), point{0, 0});
+    TSP<point, 4> tsp(cities, d);
+    REQUIRE(tsp.length({1, 2, 3}) == 6.0_a);
+    REQUIRE(tsp.length({3, 2, 1}) == 14.0_a);
+    REQUIRE_THROWS(TSP<point, 4>(cities, std::vector<double>(9, 1.)));
+  }
+  SECTION("TSPLIB geographical") {
+    // The first cities of burma14
+    write("NAME: burma3\nTYPE: TSP\nDIMENSION: 3\nEDGE_WEIGHT_TYPE: GEO\n"
+          "NODE_COORD_SECTION\n1 16.47 96.10\n2 16.47 94.44\n"
+          "3 20.09 92.54\n");
+    const auto d = instance::load_tsplib(path).distances();
+    REQUIRE(d[0 * 3 + 1] == 153.0_a);
+    REQUIRE(d[0 * 3 + 2] == 510.0_a);
+  }
+  SECTION("Unsupported TSPLIB files") {
+    write("NAME: tour\nTYPE: ATSP\nDIMENSION: 3\n");
+    REQUIRE_THROWS(instance::load_tsplib(path));
+    write("NAME: ceil\nDIMENSION: 2\nEDGE_WEIGHT_TYPE: CEIL_2D\n"
+          "NODE_COORD_SECTION\n1 0 0\n2 1 1\nEOF\n");
+    REQUIRE_THROWS(instance::load_tsplib(path).distances());
+  }
+  SECTION("CSV") {
+    write("name,latitude,longitude\nA,1.5,-2\nB,3,4.25\n");
+    const auto instance = instance::load_csv(path, "longitude", "latitude");
+    REQUIRE(instance.size() == 2);
+    REQUIRE(instance.coordinates[0] == std::array<double, 2>{-2, 1.5});
+    REQUIRE(instance.coordinates[1] == std::array<double, 2>{4.25, 3});
+    REQUIRE_THROWS(instance::load_csv(path, "x", "y"));
+  }
+}
+
+TEST_CASE("Size buckets", "[tsp]") {
+  using Sizes = buckets::Sizes<8, 16, 32>;
+  size_t chosen = 0;
+  const auto choose = [&](auto size) { chosen = decltype(size)::value; };
+  REQUIRE(buckets::dispatch(Sizes(), 5, choose));
+  REQUIRE(chosen == 8);
+  REQUIRE(buckets::dispatch(Sizes(), 16, choose));
+  REQUIRE(chosen == 16);
+  REQUIRE_FALSE(buckets::dispatch(Sizes(), 33, choose));
+  REQUIRE(buckets::largest(Sizes()) == 32);
+
+  // The same instance on a TSP of its size and on a padded one
+  constexpr size_t N = 20;
+  constexpr size_t SIZE = 32;
+  std::mt19937 rng(17);
+  std::uniform_real_distribution<double> coordinate(0, 1);
+  std::array<point, N> cities;
+  std::generate(cities.begin(), cities.end(), [&]() {
+    return point{coordinate(rng), coordinate(rng)};
+  });
+  using Exact = TSP<point, N, metrics::Euclidean>;
+  using Padded = TSP<point, SIZE, metrics::Euclidean>;
+  const Exact exact(cities);
+  Padded padded(std::vector<point>(cities.cbegin(), cities.cend()),
+                std::vector<double>());
+  REQUIRE(padded.n_cities() == N);
+  REQUIRE(padded.lower_bound() == Approx(exact.lower_bound()));
+
+  // The padding cities stay at the end of the path, in increasing order
+  const auto check = [&](const Padded::Individual &individual) {
+    for (size_t i = N - 1; i < SIZE - 1; i++) {
+      REQUIRE(individual[i] == i + 1);
+    }
+    Exact::Individual path;
+    std::copy_n(individual.cbegin(), N - 1, path.begin());
+    REQUIRE(padded.length(individual) == Approx(exact.length(path)));
+  };
+  padded.set_local_search(50);
+  for (const auto seeding :
+       {Padded::Seeding::random, Padded::Seeding::nearest_neighbour,
+        Padded::Seeding::greedy, Padded::Seeding::hilbert}) {
+    padded.set_seeding(seeding);
+    std::vector<Padded::Individual> population(10);
+    padded.generate(population.begin(), population.size(), rng);
+    for (size_t i = 0; i < population.size(); i += 2) {
+      Padded::Individual child_1;
+      Padded::Individual child_2;
+      padded.crossover(population[i], population[i + 1], child_1, child_2,
+                       rng);
+      padded.mutate(child_1, rng);
+      padded.mutate(child_2, rng);
+      check(population[i]);
+      check(child_1);
+      check(child_2);
+    }
+  }
+
+  // The padding edges, shared by every path, count toward neither the
+  // similarity nor the diversity
+  std::vector<Exact::Individual> paths(30);
+  std::vector<Padded::Individual> padded_paths(paths.size());
+  for (size_t i = 0; i < paths.size(); i++) {
+    std::iota(paths[i].begin(), paths[i].end(), 1);
+    std::shuffle(paths[i].begin(), paths[i].end(), rng);
+    std::copy(paths[i].cbegin(), paths[i].cend(), padded_paths[i].begin());
+    std::iota(snext(padded_paths[i].begin(), N - 1), padded_paths[i].end(), N);
+  }
+  auto exact_edges = exact.edge_table();
+  auto padded_edges = padded.edge_table();
+  exact_edges.assign(paths.cbegin(), paths.size());
+  padded_edges.assign(padded_paths.cbegin(), padded_paths.size());
+  REQUIRE(padded_edges.diversity() == Approx(exact_edges.diversity()));
+  REQUIRE(padded_edges.similarity(padded_paths[0]) ==
+          Approx(exact_edges.similarity(paths[0])));
+  padded_edges.assign(std::vector(10, padded_paths[0]).cbegin(), 10);
+  REQUIRE(padded_edges.similarity(padded_paths[1]) < 0.2);
+
+  REQUIRE_THROWS(Padded(std::vector<point>(SIZE + 1, point{0, 0}),
+                        std::vector<double>()));
+  REQUIRE_THROWS(Padded(std::vector<point>(cities.cbegin(), cities.cend()),
+                        std::vector<double>(N)));
+}
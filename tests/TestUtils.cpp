@@ -3,8 +3,21 @@
 //
 
 #include <catch2/catch.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <random>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 
+#include "anytime.hpp"
+#include "bandit.hpp"
+#include "fenwick_tree.hpp"
+#include "numa.hpp"
+#include "scheduler.hpp"
+#include "thread_pool.hpp"
 #include "utils.hpp"
 
 TEST_CASE("Testing utilities", "[utils]") {
@@ -62,6 +75,30 @@ TEST_CASE("Testing utilities", "[utils]") {
     }
   }
 
+  SECTION("argpartial_sort") {
+    SECTION("Empty") {
+      const std::vector<int> v{};
+      std::vector<int> i{};
+      argpartial_sort_n(v.cbegin(), v.size(), 3, i.begin());
+      REQUIRE(i.empty());
+    }
+    SECTION("Top three") {
+      const std::vector<int> v{1, 5, 4, 3, 2, -2, 7};
+      std::vector<size_t> i(v.size());
+      argpartial_sort_n(v.cbegin(), v.size(), 3, i.begin(), std::greater<>());
+      REQUIRE(std::vector<size_t>(i.cbegin(), i.cbegin() + 3) ==
+              std::vector<size_t>{6, 1, 2});
+      std::sort(i.begin(), i.end());
+      REQUIRE(i == std::vector<size_t>{0, 1, 2, 3, 4, 5, 6});
+    }
+    SECTION("More than the size") {
+      const std::vector<char> v{'a', 'h', 'p', 'b'};
+      std::vector<int> i(v.size());
+      argpartial_sort_n(v.cbegin(), v.size(), 10, i.begin());
+      REQUIRE(i == std::vector<int>{0, 3, 1, 2});
+    }
+  }
+
   SECTION("order_to") {
     SECTION("Empty") {
       std::vector<char> v{};
@@ -139,4 +176,221 @@ TEST_CASE("Testing utilities", "[utils]") {
       CHECK(v2 == std::vector<float>{0, 8, 3, 1, 6, 7, 2});
     }
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Fenwick tree", "[utils]") {
+  const std::vector<double> weights{1, 0, 2, 3, 0.5, 4};
+  genetic::FenwickTree<double> tree;
+  tree.assign(weights.cbegin(), weights.size());
+
+  SECTION("Prefix sums") {
+    REQUIRE(tree.total() == 10.5);
+    REQUIRE(tree.prefix(0) == 0);
+    REQUIRE(tree.prefix(3) == 3);
+    REQUIRE(tree.prefix(5) == 6.5);
+  }
+  SECTION("Inverse prefix sums") {
+    REQUIRE(tree.find(0) == 0);
+    REQUIRE(tree.find(0.99) == 0);
+    // Zero weights are never found
+    REQUIRE(tree.find(1) == 2);
+    REQUIRE(tree.find(6.4) == 4);
+    REQUIRE(tree.find(10.4) == 5);
+    REQUIRE(tree.find(11) == 5);
+  }
+  SECTION("Updates") {
+    tree.set(1, 5);
+    tree.set(5, 0);
+    REQUIRE(tree[1] == 5);
+    REQUIRE(tree.total() == 11.5);
+    REQUIRE(tree.prefix(2) == 6);
+    REQUIRE(tree.find(3) == 1);
+    REQUIRE(tree.find(11) == 4);
+  }
+}
+
+TEST_CASE("Bandit", "[utils]") {
+  genetic::Bandit bandit(3, 0.1, 0.05);
+  std::mt19937 rng(5);
+  const auto &probabilities = bandit.probabilities();
+  REQUIRE(probabilities[0] == Approx(1. / 3));
+
+  // Arm 1 pays off until it stops doing so, then arm 2 takes over
+  for (size_t i = 0; i < 200; i++) {
+    const auto arm = bandit.choose(rng);
+    bandit.reward(arm, arm == 1 ? 1. : 0.);
+  }
+  REQUIRE(probabilities[1] > 0.8);
+  REQUIRE(probabilities[0] >= 0.05);
+  for (size_t i = 0; i < 500; i++) {
+    const auto arm = bandit.choose(rng);
+    bandit.reward(arm, arm == 2 ? 1. : 0.);
+  }
+  REQUIRE(probabilities[2] > 0.8);
+  REQUIRE(probabilities[0] + probabilities[1] + probabilities[2] ==
+          Approx(1.));
+}
+
+TEST_CASE("Snapshot", "[utils]") {
+  genetic::Snapshot<std::array<size_t, 64>> snapshot;
+  std::array<size_t, 64> value{};
+  REQUIRE_FALSE(snapshot.read(value));
+
+  // Every published array holds a single value, so a torn read would mix
+  // two of them
+  std::atomic<bool> done{false};
+  std::thread writer([&]() {
+    for (size_t k = 1; k <= 20000; k++) {
+      std::array<size_t, 64> published;
+      published.fill(k);
+      snapshot.publish(published);
+    }
+    done = true;
+  });
+  size_t previous = 0;
+  bool consistent = true;
+  while (!done) {
+    if (snapshot.read(value)) {
+      consistent &= std::all_of(value.cbegin(), value.cend(),
+                                [&](const auto v) { return v == value[0]; });
+      consistent &= value[0] >= previous;
+      previous = value[0];
+    }
+  }
+  writer.join();
+  REQUIRE(consistent);
+  REQUIRE(snapshot.read(value));
+  REQUIRE(value[0] == 20000);
+
+  genetic::CancellationToken token;
+  const auto copy = token;
+  REQUIRE_FALSE(copy.cancelled());
+  token.cancel();
+  REQUIRE(copy.cancelled());
+}
+
+TEST_CASE("Thread pool", "[utils]") {
+  using genetic::numa::Topology;
+  REQUIRE(Topology::parse_cpu_list("0-3,8,10-11\n") ==
+          std::vector<int>{0, 1, 2, 3, 8, 10, 11});
+  REQUIRE_FALSE(Topology::detect().node_cpus.empty());
+
+  // Contiguous runs of threads per node, wrapping over the CPUs of a node
+  const Topology two_nodes{{{0, 1}, {2, 3}}};
+  const auto places = genetic::numa::spread(6, two_nodes);
+  std::vector<size_t> nodes;
+  std::vector<int> cpus;
+  for (const auto &place : places) {
+    nodes.push_back(place.node);
+    cpus.push_back(place.cpu);
+  }
+  REQUIRE(nodes == std::vector<size_t>{0, 0, 0, 1, 1, 1});
+  REQUIRE(cpus == std::vector<int>{0, 1, 0, 2, 3, 2});
+
+  genetic::ThreadPool pool(4, two_nodes);
+  REQUIRE(pool.size() == 4);
+  REQUIRE(pool.leader(1) == 0);
+  REQUIRE(pool.leader(3) == 2);
+  std::array<std::atomic<size_t>, 4> calls{};
+  for (size_t round = 0; round < 10; round++) {
+    pool.run([&](const size_t w) { calls[w]++; });
+  }
+  REQUIRE(std::all_of(calls.cbegin(), calls.cend(),
+                      [](const auto &c) { return c == 10; }));
+
+  // Slices in pairs cover the range in order
+  size_t end = 0;
+  for (size_t w = 0; w < pool.size(); w++) {
+    const auto slice = pool.slice(w, 11, 2);
+    REQUIRE(slice.first == end);
+    REQUIRE((slice.first % 2 == 0));
+    end = slice.second;
+  }
+  REQUIRE(end == 11);
+
+  const auto values = pool.allocate<int>(1000);
+  REQUIRE(std::all_of(values.cbegin(), values.cend(),
+                      [](const auto v) { return v == 0; }));
+  REQUIRE_THROWS_AS(pool.run([](const size_t w) {
+    if (w == 2)
+      throw std::runtime_error("worker failed");
+  }),
+                    std::runtime_error);
+  // Still usable after an exception
+  pool.run([&](const size_t w) { calls[w]++; });
+  REQUIRE(calls[2] == 11);
+}
+
+TEST_CASE("Work-stealing scheduler", "[utils]") {
+  genetic::ThreadPool pool(4);
+  genetic::Scheduler scheduler(pool);
+  constexpr size_t N = 1000;
+  std::vector<std::atomic<size_t>> runs(N);
+  // The chunks first given to worker 0 are slow, so the others steal them
+  scheduler.run(N, 10, [&](const size_t, const size_t begin,
+                           const size_t end) {
+    if (begin < N / 4)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    for (auto i = begin; i < end; i++) {
+      runs[i]++;
+    }
+  });
+  REQUIRE(std::all_of(runs.cbegin(), runs.cend(),
+                      [](const auto &r) { return r == 1; }));
+  size_t n_chunks = 0;
+  size_t n_stolen = 0;
+  for (size_t w = 0; w < scheduler.size(); w++) {
+    n_chunks += scheduler.stats()[w].n_chunks;
+    n_stolen += scheduler.stats()[w].n_stolen;
+    REQUIRE(scheduler.utilisation(w) >= 0);
+    REQUIRE(scheduler.utilisation(w) <= 1);
+  }
+  REQUIRE(n_chunks == N / 10);
+  REQUIRE(n_stolen > 0);
+  REQUIRE(scheduler.stats()[0].busy_seconds > 0);
+
+  // A shorter last chunk
+  std::atomic<size_t> total{0};
+  scheduler.run(25, 10, [&](const size_t, const size_t begin,
+                            const size_t end) { total += end - begin; });
+  REQUIRE(total == 25);
+  scheduler.reset_stats();
+  REQUIRE(scheduler.wall_seconds() == 0);
+
+  // Pipelined steps: a chunk only starts a step once its neighbours are done
+  // with the previous one
+  constexpr size_t N_CHUNKS = 20;
+  constexpr size_t N_STEPS = 30;
+  std::vector<std::atomic<size_t>> steps(N_CHUNKS);
+  std::atomic<bool> ordered{true};
+  const auto n_done = scheduler.pipeline(
+      N_CHUNKS * 10, 10, N_STEPS, 1,
+      [&](const size_t, const size_t step, const size_t begin,
+          const size_t) {
+        const auto chunk = begin / 10;
+        for (const auto neighbour :
+             {(chunk + 1) % N_CHUNKS, (chunk + N_CHUNKS - 1) % N_CHUNKS}) {
+          if (steps[neighbour] < step || steps[neighbour] > step + 1)
+            ordered = false;
+        }
+        if (steps[chunk] != step)
+          ordered = false;
+        if (chunk < N_CHUNKS / 4)
+          std::this_thread::sleep_for(std::chrono::microseconds(100));
+        steps[chunk]++;
+      },
+      []() { return false; });
+  REQUIRE(ordered);
+  REQUIRE(std::all_of(n_done.cbegin(), n_done.cend(),
+                      [](const auto n) { return n == N_STEPS; }));
+  n_chunks = 0;
+  for (const auto &worker : scheduler.stats()) {
+    n_chunks += worker.n_chunks;
+  }
+  REQUIRE(n_chunks == N_CHUNKS * N_STEPS);
+  const auto stopped = scheduler.pipeline(
+      100, 10, N_STEPS, 1, [](size_t, size_t, size_t, size_t) {},
+      []() { return true; });
+  REQUIRE(std::all_of(stopped.cbegin(), stopped.cend(),
+                      [](const auto n) { return n == 0; }));
+}